@@ -0,0 +1,130 @@
+#include <ijk/atomic_snapshot.h>
+#include <ijk/quat.h>
+#include <ijk/vector.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Reader latency with many readers while one writer publishes a pose at 1 kHz, or as fast as it can.
+// Compares the seqlock with a mutex around the same struct and, for one reader, the triple buffer.
+
+// Not an aggregate, pose{} would copy list initialise the members and their default constructors are explicit
+struct pose
+{
+	ijk::quat<double> orientation;
+	ijk::vector<double> position;
+
+	pose() = default;
+
+	pose(ijk::quat<double> const& q, ijk::vector<double> const& p)
+		: orientation(q)
+		, position(p)
+	{
+	}
+};
+
+static pose stamped(double n)
+{
+	return { ijk::quat<double>{ n, ijk::I{ n }, ijk::J{ n }, ijk::K{ n } }, ijk::vector<double>{ ijk::I{ n }, ijk::J{ n }, ijk::K{ n } } };
+}
+
+class locked_pose
+{
+	mutable std::mutex mutex;
+	pose value = stamped(0);
+
+public:
+	void store(pose const& p)
+	{
+		std::lock_guard lock{ mutex };
+		value = p;
+	}
+
+	pose load() const
+	{
+		std::lock_guard lock{ mutex };
+		return value;
+	}
+};
+
+static constexpr auto run_time = std::chrono::milliseconds{ 200 };
+
+// Nanoseconds per read, averaged over all readers
+template<typename Load, typename Store>
+static double reader_latency(unsigned reader_count, bool flat_out, Load const& load, Store const& store)
+{
+	std::atomic<bool> start{ false };
+	std::atomic<bool> done{ false };
+	std::atomic<long long> reads{ 0 };
+	std::atomic<double> checksum{ 0 };
+
+	std::vector<std::jthread> readers;
+	for (unsigned r = 0; r < reader_count; ++r)
+	{
+		readers.emplace_back([&]
+			{
+				while (!start.load(std::memory_order_acquire))
+				{
+				}
+				long long count = 0;
+				double sum = 0;
+				while (!done.load(std::memory_order_relaxed))
+				{
+					sum += load().orientation.w;
+					++count;
+				}
+				reads += count;
+				checksum.fetch_add(sum);
+			});
+	}
+
+	start.store(true, std::memory_order_release);
+	auto const begin = std::chrono::steady_clock::now();
+	auto next = begin;
+	for (double n = 1; std::chrono::steady_clock::now() - begin < run_time; ++n)
+	{
+		store(stamped(n));
+		if (!flat_out)
+		{
+			next += std::chrono::milliseconds{ 1 };
+			std::this_thread::sleep_until(next);
+		}
+	}
+	done = true;
+	readers.clear();
+
+	auto const elapsed = std::chrono::duration<double, std::nano>(run_time).count();
+	return checksum.load() < 0 ? 0 : elapsed * reader_count / static_cast<double>(reads.load());
+}
+
+int main()
+{
+	auto const max_readers = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+	std::cout << "ns per read, one writer and N readers\n"
+		<< std::setw(8) << "readers" << std::setw(16) << "seqlock 1kHz" << std::setw(16) << "mutex 1kHz"
+		<< std::setw(16) << "seqlock max" << std::setw(16) << "mutex max" << std::setw(16) << "triple 1kHz" << '\n';
+
+	for (unsigned readers = 1; readers <= max_readers; readers *= 2)
+	{
+		std::cout << std::setw(8) << readers << std::fixed << std::setprecision(1);
+		for (bool flat_out : { false, true })
+		{
+			ijk::atomic_snapshot<pose> snapshot{ stamped(0) };
+			locked_pose locked;
+			std::cout << std::setw(16) << reader_latency(readers, flat_out, [&] { return snapshot.load(); }, [&](pose const& p) { snapshot.store(p); })
+				<< std::setw(16) << reader_latency(readers, flat_out, [&] { return locked.load(); }, [&](pose const& p) { locked.store(p); });
+		}
+		if (readers == 1)
+		{
+			ijk::triple_buffer<pose> buffer{ stamped(0) };
+			std::cout << std::setw(16) << reader_latency(1, false, [&] { return buffer.read(); }, [&](pose const& p) { buffer.store(p); });
+		}
+		std::cout << '\n';
+	}
+}
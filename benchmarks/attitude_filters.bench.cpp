@@ -0,0 +1,77 @@
+#include <ijk/attitude_filters.h>
+#include "timing.h"
+
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+// Filters updated per second, one attitude_filters over all IMUs with AoS or SoA samples,
+// against a separate single filter per IMU stepped one after the other.
+
+int main()
+{
+	std::mt19937 rng{ 1234 };
+	std::normal_distribution<float> noise{ 0.f, 0.05f };
+
+	std::cout << std::setw(10) << "filters" << std::setw(18) << "separate M/s" << std::setw(14) << "AoS M/s" << std::setw(14) << "SoA M/s" << '\n';
+	float checksum = 0;
+	for (std::size_t count : { 16, 128, 1024, 8192, 65536 })
+	{
+		std::vector<ijk::vector<float>> gyro(count), accel(count);
+		std::vector<float> gx(count), gy(count), gz(count), ax(count), ay(count), az(count);
+		for (std::size_t n = 0; n < count; ++n)
+		{
+			gx[n] = noise(rng);
+			gy[n] = noise(rng);
+			gz[n] = 0.5f + noise(rng);
+			ax[n] = noise(rng);
+			ay[n] = noise(rng);
+			az[n] = 1.f + noise(rng);
+			gyro[n] = ijk::vector<float>{ ijk::I{ gx[n] }, ijk::J{ gy[n] }, ijk::K{ gz[n] } };
+			accel[n] = ijk::vector<float>{ ijk::I{ ax[n] }, ijk::J{ ay[n] }, ijk::K{ az[n] } };
+		}
+		ijk::vector_soa_span<float const> const gyro_soa{ gx, gy, gz };
+		ijk::vector_soa_span<float const> const accel_soa{ ax, ay, az };
+
+		// Roughly 10^7 updates per measurement whatever the filter count
+		auto const ticks = std::max<std::size_t>(10'000'000 / count, 1);
+		auto const dt = 1.f / 1000;
+		auto const rate = [&](double seconds) { return static_cast<double>(count * ticks) / seconds * 1e-6; };
+
+		std::vector<ijk::attitude_filters<float>> separate(count, ijk::attitude_filters<float>{ 1 });
+		auto const one_by_one = best_of(3, [&]
+			{
+				for (std::size_t tick = 0; tick < ticks; ++tick)
+				{
+					for (std::size_t n = 0; n < count; ++n)
+					{
+						separate[n].update(std::span{ gyro }.subspan(n, 1), std::span{ accel }.subspan(n, 1), dt);
+					}
+				}
+			});
+
+		ijk::attitude_filters<float> aos_filters{ count };
+		auto const aos = best_of(3, [&]
+			{
+				for (std::size_t tick = 0; tick < ticks; ++tick)
+				{
+					aos_filters.update(gyro, accel, dt);
+				}
+			});
+
+		ijk::attitude_filters<float> soa_filters{ count };
+		auto const soa = best_of(3, [&]
+			{
+				for (std::size_t tick = 0; tick < ticks; ++tick)
+				{
+					soa_filters.update(gyro_soa, accel_soa, dt);
+				}
+			});
+
+		checksum += separate[count - 1].orientation(0).w + aos_filters.orientation(count - 1).w + soa_filters.orientation(count - 1).w;
+		std::cout << std::setw(10) << count << std::fixed << std::setprecision(1)
+			<< std::setw(18) << rate(one_by_one) << std::setw(14) << rate(aos) << std::setw(14) << rate(soa) << '\n';
+	}
+	std::cout << "checksum " << checksum << '\n';
+}
@@ -0,0 +1,68 @@
+#include <ijk/batch.h>
+#include "timing.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+// Scaling of the batch transforms across thread counts, AoS and SoA, in place.
+// The point count is the first argument, 10^7 by default.
+
+int main(int argc, char** argv)
+{
+	auto const count = std::max<std::size_t>(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 10'000'000, 1);
+
+	std::mt19937 rng{ 1234 };
+	std::uniform_real_distribution<double> coordinate{ -10., 10. };
+	std::vector<ijk::vector<double>> points(count);
+	std::vector<double> xs(count), ys(count), zs(count);
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		xs[n] = coordinate(rng);
+		ys[n] = coordinate(rng);
+		zs[n] = coordinate(rng);
+		points[n] = ijk::vector<double>{ ijk::I{ xs[n] }, ijk::J{ ys[n] }, ijk::K{ zs[n] } };
+	}
+
+	// Unit length, so repeated runs in place keep the points bounded
+	auto const q = ijk::quat<double>{ 0.5, ijk::I{ 0.5 }, ijk::J{ 0.5 }, ijk::K{ 0.5 } };
+	auto const translation = ijk::vector<double>{ ijk::I{ 1e-3 } };
+	ijk::vector_soa_span<double> const soa{ xs, ys, zs };
+
+	std::vector<unsigned> thread_counts;
+	auto const hardware = std::max(std::thread::hardware_concurrency(), 1u);
+	for (unsigned threads = 1; threads < hardware; threads *= 2)
+	{
+		thread_counts.push_back(threads);
+	}
+	thread_counts.push_back(hardware);
+
+	// Each point is read and written once, 48 bytes of traffic
+	auto const bytes = static_cast<double>(count) * 2 * 3 * sizeof(double);
+	std::cout << count << " points, rotate and translate in place\n"
+		<< std::setw(8) << "threads" << std::setw(12) << "AoS ms" << std::setw(12) << "SoA ms"
+		<< std::setw(14) << "SoA Mpts/s" << std::setw(10) << "speedup" << std::setw(10) << "GB/s" << '\n';
+
+	double single = 0;
+	for (auto const threads : thread_counts)
+	{
+		ijk::batch_options const options{ .thread_count = threads };
+		auto const aos = best_of(5, [&] { ijk::transform(q, translation, std::span{ points }, options); });
+		auto const seconds = best_of(5, [&] { ijk::transform(q, translation, soa, options); });
+		if (threads == 1)
+		{
+			single = seconds;
+		}
+		std::cout << std::setw(8) << threads << std::fixed << std::setprecision(2)
+			<< std::setw(12) << aos * 1e3 << std::setw(12) << seconds * 1e3
+			<< std::setw(14) << static_cast<double>(count) / seconds * 1e-6
+			<< std::setw(10) << single / seconds << std::setw(10) << bytes / seconds * 1e-9 << '\n';
+	}
+
+	// Keeps the transforms from being optimised away
+	std::cout << "checksum " << points[count / 2].x.value() + xs[count / 3] << '\n';
+}
@@ -0,0 +1,129 @@
+#include <ijk/orientation_index.h>
+#include "timing.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <vector>
+
+// Nearest orientation lookup, the index against a brute force scan over the same library.
+// Arguments: library size, 10^6 by default, and query count, 1000 by default.
+
+static ijk::quat<float> normalised(float w, float x, float y, float z)
+{
+	auto const length = std::sqrt(w * w + x * x + y * y + z * z);
+	return ijk::quat<float>{ w / length, ijk::I{ x / length }, ijk::J{ y / length }, ijk::K{ z / length } };
+}
+
+// The scan a library lookup starts out as: the largest |dot| is the smallest angle
+static std::size_t brute_force_nearest(std::vector<ijk::quat<float>> const& library, ijk::quat<float> const& query)
+{
+	std::size_t best = 0;
+	float best_dot = -1;
+	for (std::size_t n = 0; n < library.size(); ++n)
+	{
+		auto const& q = library[n];
+		auto const dot = std::abs(q.w * query.w + q.i.value() * query.i.value() + q.j.value() * query.j.value() + q.k.value() * query.k.value());
+		if (dot > best_dot)
+		{
+			best_dot = dot;
+			best = n;
+		}
+	}
+	return best;
+}
+
+int main(int argc, char** argv)
+{
+	auto const library_size = std::max<std::size_t>(argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 1'000'000, 1);
+	auto const query_count = std::max<std::size_t>(argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1000, 1);
+
+	std::mt19937 rng{ 1234 };
+	std::normal_distribution<float> normal;
+	auto random_orientation = [&] { return normalised(normal(rng), normal(rng), normal(rng), normal(rng)); };
+
+	std::vector<ijk::quat<float>> library(library_size);
+	std::ranges::generate(library, random_orientation);
+
+	// Uniform queries are the hard case for any space partition in four dimensions,
+	// live poses close to a reference, here within a few degrees and with random sign, are the common one
+	std::vector<ijk::quat<float>> uniform(query_count);
+	std::ranges::generate(uniform, random_orientation);
+	std::vector<ijk::quat<float>> close(query_count);
+	std::uniform_int_distribution<std::size_t> pick{ 0, library_size - 1 };
+	for (auto& query : close)
+	{
+		auto const& q = library[pick(rng)];
+		auto const sign = rng() % 2 ? 1.f : -1.f;
+		query = normalised(sign * (q.w + 0.02f * normal(rng)), sign * (q.i.value() + 0.02f * normal(rng)),
+			sign * (q.j.value() + 0.02f * normal(rng)), sign * (q.k.value() + 0.02f * normal(rng)));
+	}
+
+	std::cout << std::fixed << std::setprecision(2) << library_size << " references, " << query_count << " queries\n";
+
+	ijk::orientation_index<float> index;
+	auto const serial_build = best_of(1, [&] { index = ijk::orientation_index<float>{ library, { .thread_count = 1 } }; });
+	auto const parallel_build = best_of(1, [&] { index = ijk::orientation_index<float>{ library }; });
+	std::cout << "build ms: one thread " << serial_build * 1e3 << ", all threads " << parallel_build * 1e3 << '\n';
+
+	std::vector<std::byte> bytes;
+	auto const save = best_of(3, [&] { bytes = index.serialize(); });
+	auto const load = best_of(3, [&] { index = *ijk::orientation_index<float>::deserialize(bytes); });
+	std::cout << "serialized MB " << static_cast<double>(bytes.size()) * 1e-6 << ", serialize ms " << save * 1e3 << ", deserialize ms " << load * 1e3 << '\n';
+
+	auto const per_query = [&](double seconds) { return seconds / static_cast<double>(query_count) * 1e6; };
+	std::cout << std::setw(10) << "queries" << std::setw(14) << "brute us" << std::setw(14) << "k=1 us" << std::setw(14) << "k=8 us"
+		<< std::setw(16) << "within 2deg us" << std::setw(16) << "batch k=8 us" << std::setw(10) << "speedup" << std::setw(12) << "mismatches" << '\n';
+
+	// Result sizes summed and printed, so the optimiser cannot drop unused queries
+	std::size_t checksum = 0;
+	for (auto const* queries : { &uniform, &close })
+	{
+		std::vector<std::size_t> brute(query_count);
+		auto const brute_seconds = best_of(1, [&]
+			{
+				for (std::size_t n = 0; n < query_count; ++n)
+				{
+					brute[n] = brute_force_nearest(library, (*queries)[n]);
+				}
+			});
+
+		std::size_t mismatches = 0;
+		auto const nearest = best_of(3, [&]
+			{
+				mismatches = 0;
+				for (std::size_t n = 0; n < query_count; ++n)
+				{
+					// Ties and float rounding of the two distances can pick different but equally close references
+					auto const found = index.nearest((*queries)[n], 1);
+					mismatches += found.front().index != brute[n];
+				}
+			});
+		auto const nearest8 = best_of(3, [&]
+			{
+				for (auto const& query : *queries)
+				{
+					checksum += index.nearest(query, 8).size();
+				}
+			});
+		auto const within = best_of(3, [&]
+			{
+				for (auto const& query : *queries)
+				{
+					checksum += index.within(query, 2 * std::numbers::pi_v<float> / 180).size();
+				}
+			});
+		std::vector<ijk::neighbour<float>> out(query_count * 8);
+		auto const batched = best_of(3, [&] { index.nearest(*queries, 8, out); });
+
+		std::cout << std::setw(10) << (queries == &uniform ? "uniform" : "close")
+			<< std::setw(14) << per_query(brute_seconds) << std::setw(14) << per_query(nearest) << std::setw(14) << per_query(nearest8)
+			<< std::setw(16) << per_query(within) << std::setw(16) << per_query(batched)
+			<< std::setw(10) << brute_seconds / nearest << std::setw(12) << mismatches << '\n';
+	}
+	std::cout << "checksum " << checksum << '\n';
+}
@@ -0,0 +1,104 @@
+#include <ijk/soa.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+
+// Heap allocations and time per frame for frame temporaries in soa_vector,
+// once on the default heap allocator and once on the thread's frame arena.
+// The same frame loop as tests/soa.test.cpp. The element count is the first argument, 30000 by default,
+// the frame count the second, 10 by default.
+
+// Every heap allocation in this program goes through here
+static std::atomic<long> heap_allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+	++heap_allocations;
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	++heap_allocations;
+	auto const align = static_cast<std::size_t>(alignment);
+	if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+// One frame of temporaries, the same work every frame
+template<template<typename> typename Container>
+static float frame(ijk::quat<float> const& q, int frame_number, int count)
+{
+	float checksum = 0;
+	{
+		Container<ijk::vector<float>> points;
+		Container<ijk::quat<float>> orientations;
+		Container<ijk::complex<float>> phases;
+		for (int n = 0; n < count; ++n)
+		{
+			auto const f = static_cast<float>(n + frame_number);
+			points.push_back(ijk::vector<float>{ ijk::I{ f }, ijk::J{ 1.f }, ijk::K{ -f } });
+			orientations.push_back(q);
+			phases.push_back(ijk::complex<float>{ f, ijk::I{ 1.f } });
+		}
+		ijk::rotate(q, points.soa());
+		checksum = points[count / 2].x.value() + orientations[count / 3].w + phases[count / 4].real;
+	}
+	// The frame's containers are gone, their memory can be handed out again
+	ijk::thread_frame_arena().reset();
+	return checksum;
+}
+
+template<typename V>
+using heap_soa_vector = ijk::soa_vector<V>;
+
+template<typename V>
+using frame_soa_vector = ijk::frame_soa_vector<V>;
+
+template<template<typename> typename Container>
+static float run(char const* name, int count, int frames)
+{
+	auto const q = 0.5f + ijk::I{ 0.5f } + ijk::J{ 0.5f } + ijk::K{ 0.5f };
+	float checksum = 0;
+	std::cout << name << '\n' << std::setw(8) << "frame" << std::setw(14) << "allocations" << std::setw(12) << "us" << '\n';
+	for (int n = 0; n < frames; ++n)
+	{
+		auto const before = heap_allocations.load();
+		auto const start = std::chrono::steady_clock::now();
+		checksum += frame<Container>(q, n, count);
+		auto const seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << std::setw(8) << n << std::setw(14) << heap_allocations.load() - before
+			<< std::setw(12) << std::fixed << std::setprecision(1) << seconds * 1e6 << '\n';
+	}
+	return checksum;
+}
+
+int main(int argc, char** argv)
+{
+	auto const count = std::max(argc > 1 ? std::atoi(argv[1]) : 30000, 1);
+	auto const frames = std::max(argc > 2 ? std::atoi(argv[2]) : 10, 1);
+
+	std::cout << count << " vectors, quaternions and complex numbers per frame\n";
+	auto checksum = run<heap_soa_vector>("soa_vector", count, frames);
+	checksum += run<frame_soa_vector>("frame_soa_vector", count, frames);
+
+	// Keeps the frames from being optimised away
+	std::cout << "checksum " << checksum << '\n';
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+// Seconds taken by the fastest of several runs of f, the minimum is the run least disturbed by other load
+template<typename F>
+double best_of(int runs, F&& f)
+{
+	auto best = std::numeric_limits<double>::infinity();
+	for (int n = 0; n < runs; ++n)
+	{
+		auto const start = std::chrono::steady_clock::now();
+		f();
+		best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+	}
+	return best;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+
+namespace ijk {
+
+	// Bump allocator for per frame temporaries. Deallocation does nothing, reset() makes all
+	// memory handed out so far reusable at once. Blocks taken from upstream are kept across
+	// resets, so once a frame has seen its peak usage later frames do not allocate at all.
+	class monotonic_arena : public std::pmr::memory_resource
+	{
+		struct block
+		{
+			std::byte* data;
+			std::size_t size;
+		};
+
+		static constexpr std::size_t block_alignment = 64;
+
+		std::pmr::memory_resource* upstream;
+		std::vector<block> blocks;
+		std::size_t next_block_size;
+		std::size_t current = 0; // block being bumped
+		std::size_t offset = 0;  // bytes used in the current block
+
+	public:
+		explicit monotonic_arena(std::size_t initial_size = 1 << 16, std::pmr::memory_resource* upstream_resource = std::pmr::new_delete_resource())
+			: upstream(upstream_resource)
+			, next_block_size(initial_size > 0 ? initial_size : 1)
+		{
+		}
+
+		monotonic_arena(monotonic_arena const&) = delete;
+		monotonic_arena& operator=(monotonic_arena const&) = delete;
+
+		~monotonic_arena() override
+		{
+			for (auto const& b : blocks)
+			{
+				upstream->deallocate(b.data, b.size, block_alignment);
+			}
+		}
+
+		// Everything allocated before is invalid afterwards
+		void reset() noexcept
+		{
+			current = 0;
+			offset = 0;
+		}
+
+		// Bytes held from upstream, used or not
+		std::size_t capacity() const noexcept
+		{
+			std::size_t total = 0;
+			for (auto const& b : blocks)
+			{
+				total += b.size;
+			}
+			return total;
+		}
+
+	private:
+		void* do_allocate(std::size_t bytes, std::size_t alignment) override
+		{
+			if (bytes > std::numeric_limits<std::size_t>::max() - alignment)
+			{
+				throw std::bad_alloc{};
+			}
+			for (;; ++current, offset = 0)
+			{
+				if (current == blocks.size())
+				{
+					grow(bytes + alignment);
+				}
+				auto const& b = blocks[current];
+				auto const base = reinterpret_cast<std::uintptr_t>(b.data);
+				auto const start = (base + offset + alignment - 1) / alignment * alignment - base;
+				if (start <= b.size && bytes <= b.size - start)
+				{
+					offset = start + bytes;
+					return b.data + start;
+				}
+			}
+		}
+
+		void do_deallocate(void*, std::size_t, std::size_t) override
+		{
+		}
+
+		bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+		{
+			return this == &other;
+		}
+
+		// No upstream provides half the address space, and asking for sizes close to the limit
+		// is not safe either: aligned operator new rounds the size up, which can wrap to 0.
+		static constexpr std::size_t max_block_size = std::numeric_limits<std::size_t>::max() / 2;
+
+		void grow(std::size_t at_least)
+		{
+			if (at_least > max_block_size)
+			{
+				throw std::bad_alloc{};
+			}
+			while (next_block_size < at_least)
+			{
+				next_block_size = std::min(next_block_size, max_block_size / 2) * 2;
+			}
+			auto* data = static_cast<std::byte*>(upstream->allocate(next_block_size, block_alignment));
+			blocks.push_back({ data, next_block_size });
+			next_block_size = std::min(next_block_size, max_block_size / 2) * 2;
+		}
+	};
+
+	// One arena per thread, for the frame_allocator. Call reset() on it at the end of each frame.
+	inline monotonic_arena& thread_frame_arena()
+	{
+		thread_local monotonic_arena arena;
+		return arena;
+	}
+
+	// Stateless allocator drawing from the calling thread's frame arena.
+	// Memory is valid until that thread resets its arena, containers using it must not outlive the frame
+	// or be grown from another thread.
+	template<typename T>
+	struct frame_allocator
+	{
+		using value_type = T;
+		using is_always_equal = std::true_type;
+
+		frame_allocator() = default;
+
+		template<typename U>
+		constexpr frame_allocator(frame_allocator<U> const&) noexcept
+		{
+		}
+
+		T* allocate(std::size_t n)
+		{
+			if (n > std::numeric_limits<std::size_t>::max() / sizeof(T))
+			{
+				throw std::bad_array_new_length{};
+			}
+			return static_cast<T*>(thread_frame_arena().allocate(n * sizeof(T), alignof(T)));
+		}
+
+		void deallocate(T*, std::size_t) noexcept
+		{
+		}
+
+		template<typename U>
+		constexpr bool operator==(frame_allocator<U> const&) const noexcept
+		{
+			return true;
+		}
+	};
+
+} // namespace ijk
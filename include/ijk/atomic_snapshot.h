@@ -0,0 +1,183 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <concepts>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+
+namespace ijk {
+
+	namespace detail
+	{
+		// Values are copied word by word. Spelled out instead of std::is_trivially_copyable, which g++ 12
+		// reports as false for quat and vector once one has been constructed in the translation unit.
+		template<typename T>
+		concept snapshotable = std::is_trivially_copy_constructible_v<T> && std::is_trivially_copy_assignable_v<T>
+			&& std::is_trivially_destructible_v<T> && std::default_initializable<T>;
+	}
+
+	// Seqlock holding the latest value of a quat, vector, complex or other trivially copyable type.
+	// One thread may call store, any number of threads may call load concurrently.
+	// Readers never block the writer and never see a value that is half old and half new,
+	// a reader that overlaps a store retries until it has copied a consistent value.
+	// The value lives in relaxed atomic words rather than a plain T so that racing reads are well defined.
+	template<detail::snapshotable T>
+	class atomic_snapshot
+	{
+		using word = std::size_t;
+		static constexpr std::size_t word_count = (sizeof(T) + sizeof(word) - 1) / sizeof(word);
+		using words = std::array<word, word_count>;
+
+		// Writer and readers touch the sequence on every access, keep it off the data cache line
+		alignas(64) std::atomic<std::size_t> sequence{ 0 };
+		alignas(64) std::array<std::atomic<word>, word_count> data{};
+
+	public:
+		using value_type = T;
+
+		atomic_snapshot()
+			: atomic_snapshot(T{})
+		{
+		}
+
+		explicit atomic_snapshot(T const& value)
+		{
+			auto const packed = pack(value);
+			for (std::size_t n = 0; n < word_count; ++n)
+			{
+				data[n].store(packed[n], std::memory_order_relaxed);
+			}
+		}
+
+		atomic_snapshot(atomic_snapshot const&) = delete;
+		atomic_snapshot& operator=(atomic_snapshot const&) = delete;
+
+		// Only one thread may store at a time.
+		void store(T const& value) noexcept
+		{
+			auto const packed = pack(value);
+			auto const seq = sequence.load(std::memory_order_relaxed);
+			sequence.store(seq + 1, std::memory_order_relaxed); // odd: write in progress
+			std::atomic_thread_fence(std::memory_order_release);
+			for (std::size_t n = 0; n < word_count; ++n)
+			{
+				data[n].store(packed[n], std::memory_order_relaxed);
+			}
+			sequence.store(seq + 2, std::memory_order_release);
+		}
+
+		T load() const noexcept
+		{
+			T result;
+			while (!try_load(result))
+			{
+			}
+			return result;
+		}
+
+		// Single attempt at reading, returns false instead of retrying if a store was in progress.
+		bool try_load(T& out) const noexcept
+		{
+			auto const before = sequence.load(std::memory_order_acquire);
+			if (before & 1)
+			{
+				return false;
+			}
+
+			words packed;
+			for (std::size_t n = 0; n < word_count; ++n)
+			{
+				packed[n] = data[n].load(std::memory_order_relaxed);
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (sequence.load(std::memory_order_relaxed) != before)
+			{
+				return false;
+			}
+
+			std::memcpy(static_cast<void*>(&out), packed.data(), sizeof(T));
+			return true;
+		}
+
+		// Number of completed stores, usable by readers to detect new values.
+		std::size_t version() const noexcept
+		{
+			return sequence.load(std::memory_order_acquire) / 2;
+		}
+
+	private:
+		static words pack(T const& value) noexcept
+		{
+			words packed{};
+			std::memcpy(packed.data(), &value, sizeof(T));
+			return packed;
+		}
+	};
+
+	// Triple buffer for one writer and one reader.
+	// Unlike atomic_snapshot the reader never retries, both sides only ever exchange a slot index.
+	// The writer fills its private back slot and publishes it, the reader picks up the latest
+	// published slot and keeps reading it undisturbed until it asks for a newer one.
+	template<std::copyable T>
+	class triple_buffer
+	{
+		static constexpr unsigned index_mask = 0b011;
+		static constexpr unsigned fresh_bit = 0b100;
+
+		struct alignas(64) slot
+		{
+			T value{};
+		};
+
+		std::array<slot, 3> slots{};
+		alignas(64) std::atomic<unsigned> middle{ 1 };
+		alignas(64) unsigned back = 0;  // owned by writer
+		alignas(64) unsigned front = 2; // owned by reader
+
+	public:
+		using value_type = T;
+
+		triple_buffer() = default;
+
+		explicit triple_buffer(T const& value)
+			: slots{ slot{ value }, slot{ value }, slot{ value } }
+		{
+		}
+
+		triple_buffer(triple_buffer const&) = delete;
+		triple_buffer& operator=(triple_buffer const&) = delete;
+
+		// Writer side: the slot to fill before publish.
+		T& back_buffer() noexcept
+		{
+			return slots[back].value;
+		}
+
+		void publish() noexcept
+		{
+			auto const previous = middle.exchange(back | fresh_bit, std::memory_order_acq_rel);
+			back = previous & index_mask;
+		}
+
+		void store(T const& value)
+		{
+			back_buffer() = value;
+			publish();
+		}
+
+		// Reader side: the latest published value, stays valid until the next call to read.
+		T const& read() noexcept
+		{
+			if (middle.load(std::memory_order_relaxed) & fresh_bit)
+			{
+				auto const previous = middle.exchange(front, std::memory_order_acq_rel);
+				front = previous & index_mask;
+			}
+			return slots[front].value;
+		}
+	};
+
+} // namespace ijk
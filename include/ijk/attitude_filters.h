@@ -0,0 +1,175 @@
+#pragma once
+
+#include "quat.h"
+#include "vector.h"
+#include "batch.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+
+namespace ijk {
+
+	// Madgwick gradient descent attitude filters (gyroscope and accelerometer, no magnetometer)
+	// for many IMUs at once. Filter states are kept as structure of arrays and one update advances
+	// every filter by one sample, the loop over filters is branch free so the compiler can
+	// vectorise it across filters instead of within one quaternion. GCC and Clang only vectorise
+	// the square roots with -fno-math-errno, which is worth an order of magnitude here.
+	// Orientations map sensor frame to earth frame, gravity is +k in the earth frame.
+	template<std::floating_point T>
+	class attitude_filters
+	{
+		std::vector<T> w;
+		std::vector<T> x;
+		std::vector<T> y;
+		std::vector<T> z;
+		T beta;
+
+	public:
+		using value_type = T;
+
+		// beta is the gradient step gain, larger trusts the accelerometer more
+		explicit attitude_filters(std::size_t count, T gain = T{ 0.1 })
+			: w(count, T{ 1 })
+			, x(count)
+			, y(count)
+			, z(count)
+			, beta(gain)
+		{
+		}
+
+		std::size_t size() const
+		{
+			return w.size();
+		}
+
+		T gain() const
+		{
+			return beta;
+		}
+
+		void set_gain(T gain)
+		{
+			beta = gain;
+		}
+
+		quat<T> orientation(std::size_t n) const
+		{
+			return quat<T>{ w[n], I{ x[n] }, J{ y[n] }, K{ z[n] } };
+		}
+
+		void set_orientation(std::size_t n, quat<T> const& q)
+		{
+			w[n] = q.w;
+			x[n] = q.i.value();
+			y[n] = q.j.value();
+			z[n] = q.k.value();
+		}
+
+		// One sample per filter, gyro in radians per second, accel in any unit.
+		// An accel sample of zero skips the correction for that filter.
+		void update(std::type_identity_t<std::span<vector<T> const>> gyro, std::type_identity_t<std::span<vector<T> const>> accel, T dt)
+		{
+			assert(gyro.size() == size() && accel.size() == size());
+			T* const qw = w.data();
+			T* const qx = x.data();
+			T* const qy = y.data();
+			T* const qz = z.data();
+			for (std::size_t n = 0; n < size(); ++n)
+			{
+				step(qw[n], qx[n], qy[n], qz[n], gyro[n].x.value(), gyro[n].y.value(), gyro[n].z.value(),
+					accel[n].x.value(), accel[n].y.value(), accel[n].z.value(), beta, dt);
+			}
+		}
+
+		void update(std::type_identity_t<vector_soa_span<T const>> gyro, std::type_identity_t<vector_soa_span<T const>> accel, T dt)
+		{
+			assert(gyro.size() == size() && accel.size() == size());
+			// Six input and four state arrays are too many possible overlaps for the compiler to
+			// check at run time, so states are stepped in local blocks that cannot alias the inputs.
+			constexpr std::size_t block = 64;
+			T qw[block], qx[block], qy[block], qz[block];
+			for (std::size_t begin = 0; begin < size(); begin += block)
+			{
+				auto const count = std::min(block, size() - begin);
+				std::copy_n(w.data() + begin, count, qw);
+				std::copy_n(x.data() + begin, count, qx);
+				std::copy_n(y.data() + begin, count, qy);
+				std::copy_n(z.data() + begin, count, qz);
+				T const* const gx = gyro.x.data() + begin;
+				T const* const gy = gyro.y.data() + begin;
+				T const* const gz = gyro.z.data() + begin;
+				T const* const ax = accel.x.data() + begin;
+				T const* const ay = accel.y.data() + begin;
+				T const* const az = accel.z.data() + begin;
+				for (std::size_t n = 0; n < count; ++n)
+				{
+					step(qw[n], qx[n], qy[n], qz[n], gx[n], gy[n], gz[n], ax[n], ay[n], az[n], beta, dt);
+				}
+				std::copy_n(qw, count, w.data() + begin);
+				std::copy_n(qx, count, x.data() + begin);
+				std::copy_n(qy, count, y.data() + begin);
+				std::copy_n(qz, count, z.data() + begin);
+			}
+		}
+
+	private:
+		// Madgwick's IMU update written out on components, see
+		// S. Madgwick, An efficient orientation filter for inertial and inertial/magnetic sensor arrays, 2010
+		static void step(T& w, T& x, T& y, T& z, T gx, T gy, T gz, T ax, T ay, T az, T beta, T dt)
+		{
+			T q0 = w;
+			T q1 = x;
+			T q2 = y;
+			T q3 = z;
+
+			// Rate of change from the gyroscope, half of q * (0, g)
+			T dq0 = T{ 0.5 } * (-q1 * gx - q2 * gy - q3 * gz);
+			T dq1 = T{ 0.5 } * (q0 * gx + q2 * gz - q3 * gy);
+			T dq2 = T{ 0.5 } * (q0 * gy - q1 * gz + q3 * gx);
+			T dq3 = T{ 0.5 } * (q0 * gz + q1 * gy - q2 * gx);
+
+			T const accel_squared = ax * ax + ay * ay + az * az;
+			// 0 or 1 masks rather than ?: around the divisions. Under the default -ftrapping-math the compiler
+			// may not evaluate a division that the source skips, so ?: stays a branch and stops vectorisation.
+			T const has_accel = static_cast<T>(accel_squared > 0);
+			T const accel_scale = has_accel / std::sqrt(accel_squared + (1 - has_accel));
+			ax *= accel_scale;
+			ay *= accel_scale;
+			az *= accel_scale;
+
+			// Gradient of the error between measured and predicted gravity
+			T const q0q0 = q0 * q0;
+			T const q1q1 = q1 * q1;
+			T const q2q2 = q2 * q2;
+			T const q3q3 = q3 * q3;
+			T s0 = 4 * q0 * q2q2 + 2 * q2 * ax + 4 * q0 * q1q1 - 2 * q1 * ay;
+			T s1 = 4 * q1 * q3q3 - 2 * q3 * ax + 4 * q0q0 * q1 - 2 * q0 * ay - 4 * q1 + 8 * q1 * q1q1 + 8 * q1 * q2q2 + 4 * q1 * az;
+			T s2 = 4 * q0q0 * q2 + 2 * q0 * ax + 4 * q2 * q3q3 - 2 * q3 * ay - 4 * q2 + 8 * q2 * q1q1 + 8 * q2 * q2q2 + 4 * q2 * az;
+			T s3 = 4 * q1q1 * q3 - 2 * q1 * ax + 4 * q2q2 * q3 - 2 * q2 * ay;
+			T const gradient_squared = s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3;
+			T const has_gradient = has_accel * static_cast<T>(gradient_squared > 0);
+			T const step_size = beta * has_gradient / std::sqrt(gradient_squared + (1 - has_gradient));
+			dq0 -= step_size * s0;
+			dq1 -= step_size * s1;
+			dq2 -= step_size * s2;
+			dq3 -= step_size * s3;
+
+			q0 += dq0 * dt;
+			q1 += dq1 * dt;
+			q2 += dq2 * dt;
+			q3 += dq3 * dt;
+			T const length = 1 / std::sqrt(q0 * q0 + q1 * q1 + q2 * q2 + q3 * q3);
+			w = q0 * length;
+			x = q1 * length;
+			y = q2 * length;
+			z = q3 * length;
+		}
+	};
+
+} // namespace ijk
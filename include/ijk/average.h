@@ -0,0 +1,266 @@
+#pragma once
+
+#include "quat.h"
+#include "batch.h"
+#include "precision.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <ranges>
+#include <vector>
+
+
+namespace ijk {
+
+	template<std::floating_point T>
+	struct quat_average
+	{
+		// Unit quaternion with non-negative w
+		quat<T> mean{ T{ 1 } };
+		// Angle in radians, 0 when all samples agree. cos^2(spread/2) is the weighted mean
+		// of cos^2(angle/2) over the angles between each sample and the mean.
+		T spread{ 0 };
+		T total_weight{ 0 };
+	};
+
+	namespace detail
+	{
+		template<typename T>
+		using matrix4 = std::array<std::array<T, 4>, 4>;
+
+		// Cyclic Jacobi sweeps on a symmetric 4x4 matrix, returns the eigenvector of the largest eigenvalue.
+		// Plenty fast for a single 4x4 and unlike power iteration it does not care how close
+		// the two largest eigenvalues are.
+		template<typename T>
+		std::array<T, 4> dominant_eigenvector(matrix4<T> a, T& eigenvalue)
+		{
+			matrix4<T> v{};
+			for (int n = 0; n < 4; ++n)
+			{
+				v[n][n] = 1;
+			}
+
+			for (int sweep = 0; sweep < 32; ++sweep)
+			{
+				T off_diagonal = 0;
+				T diagonal = 0;
+				for (int p = 0; p < 4; ++p)
+				{
+					diagonal += a[p][p] * a[p][p];
+					for (int q = p + 1; q < 4; ++q)
+					{
+						off_diagonal += a[p][q] * a[p][q];
+					}
+				}
+				if (off_diagonal <= diagonal * std::numeric_limits<T>::epsilon() * std::numeric_limits<T>::epsilon())
+				{
+					break;
+				}
+
+				for (int p = 0; p < 4; ++p)
+				{
+					for (int q = p + 1; q < 4; ++q)
+					{
+						if (a[p][q] == 0)
+						{
+							continue;
+						}
+						T const theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+						T const t = std::copysign(T{ 1 }, theta) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+						T const c = 1 / std::sqrt(t * t + 1);
+						T const s = t * c;
+						for (int k = 0; k < 4; ++k)
+						{
+							T const akp = a[k][p];
+							T const akq = a[k][q];
+							a[k][p] = c * akp - s * akq;
+							a[k][q] = s * akp + c * akq;
+							T const vkp = v[k][p];
+							T const vkq = v[k][q];
+							v[k][p] = c * vkp - s * vkq;
+							v[k][q] = s * vkp + c * vkq;
+						}
+						for (int k = 0; k < 4; ++k)
+						{
+							T const apk = a[p][k];
+							T const aqk = a[q][k];
+							a[p][k] = c * apk - s * aqk;
+							a[q][k] = s * apk + c * aqk;
+						}
+					}
+				}
+			}
+
+			int largest = 0;
+			for (int n = 1; n < 4; ++n)
+			{
+				if (a[n][n] > a[largest][largest])
+				{
+					largest = n;
+				}
+			}
+			eigenvalue = a[largest][largest];
+			return { v[0][largest], v[1][largest], v[2][largest], v[3][largest] };
+		}
+	}
+
+	// Streaming weighted average of unit quaternions (Markley et al. 2007).
+	// Sums the outer products w * q * q^T so q and -q count as the same orientation,
+	// the mean is the dominant eigenvector of the sum. Samples are absorbed one at a time
+	// and never revisited, accumulators of separate batches or threads can be merged.
+	// With accumulation::kahan the sums are compensated, pairwise is the same as plain here.
+	template<std::floating_point T, typename Accumulation = accumulation::plain>
+	class quat_accumulator
+	{
+		// Upper triangle of the symmetric sum, row by row in w, i, j, k order
+		std::array<detail::accumulator<T, Accumulation>, 10> sum{};
+		detail::accumulator<T, Accumulation> weight{};
+
+	public:
+		using value_type = T;
+
+		constexpr void add(quat<T> const& q, T sample_weight = 1)
+		{
+			std::array<T, 4> const c{ q.w, q.i.value(), q.j.value(), q.k.value() };
+			std::size_t n = 0;
+			for (std::size_t row = 0; row < 4; ++row)
+			{
+				T const weighted = sample_weight * c[row];
+				for (std::size_t col = row; col < 4; ++col)
+				{
+					sum[n++].add(weighted * c[col]);
+				}
+			}
+			weight.add(sample_weight);
+		}
+
+		constexpr void merge(quat_accumulator const& other)
+		{
+			for (std::size_t n = 0; n < sum.size(); ++n)
+			{
+				sum[n].merge(other.sum[n]);
+			}
+			weight.merge(other.weight);
+		}
+
+		constexpr T total_weight() const
+		{
+			return weight.value();
+		}
+
+		quat_average<T> result() const
+		{
+			T const total = weight.value();
+			if (total <= 0)
+			{
+				return {};
+			}
+
+			detail::matrix4<T> m{};
+			std::size_t n = 0;
+			for (std::size_t row = 0; row < 4; ++row)
+			{
+				for (std::size_t col = row; col < 4; ++col)
+				{
+					m[row][col] = m[col][row] = sum[n++].value();
+				}
+			}
+
+			T eigenvalue;
+			auto e = detail::dominant_eigenvector(m, eigenvalue);
+			T const length = std::sqrt(e[0] * e[0] + e[1] * e[1] + e[2] * e[2] + e[3] * e[3]);
+			T const sign = e[0] < 0 ? -1 : 1;
+			for (auto& c : e)
+			{
+				c *= sign / length;
+			}
+
+			// eigenvalue / weight is the weighted mean of (sample . mean)^2 = cos^2(angle/2)
+			T const mean_cos2 = std::clamp(eigenvalue / total, T{ 0 }, T{ 1 });
+			return {
+				quat<T>{ e[0], I{ e[1] }, J{ e[2] }, K{ e[3] } },
+				2 * std::acos(std::sqrt(mean_cos2)),
+				total };
+		}
+	};
+
+	namespace detail
+	{
+		// Partial sums per chunk rather than per thread, the result does not depend on the thread count.
+		// Merging the chunk sums at the end also keeps each plain running sum short.
+		template<typename Policy, typename Sample>
+		auto average_chunks(std::size_t count, batch_options const& options, Sample const& sample)
+		{
+			using storage_t = typename Policy::storage_type;
+			using accumulator_t = quat_accumulator<typename Policy::compute_type, typename Policy::accumulation_type>;
+
+			auto const chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+			std::vector<accumulator_t> partial((count + chunk_size - 1) / chunk_size);
+			parallel_chunks(count, options, [&](std::size_t begin, std::size_t end)
+				{
+					auto& accumulator = partial[begin / chunk_size];
+					for (auto n = begin; n < end; ++n)
+					{
+						sample(accumulator, n);
+					}
+				});
+
+			accumulator_t total;
+			for (auto const& accumulator : partial)
+			{
+				total.merge(accumulator);
+			}
+			auto const result = total.result();
+			return quat_average<storage_t>{
+				rebind_to<storage_t>(result.mean),
+				static_cast<storage_t>(result.spread),
+				static_cast<storage_t>(result.total_weight) };
+		}
+
+		template<typename Samples>
+		concept quat_samples = std::ranges::random_access_range<Samples> && std::ranges::sized_range<Samples>
+			&& is_quat<std::ranges::range_value_t<Samples>>;
+	}
+
+	// Average with a precision policy, e.g. average<precision<float, double, accumulation::kahan>>(samples)
+	// for float samples summed in compensated double. The result has the policy's storage type.
+	template<detail::is_precision Policy, detail::quat_samples Samples>
+	auto average(Samples const& samples, batch_options const& options = {})
+	{
+		using compute_t = typename Policy::compute_type;
+		auto const first = std::ranges::begin(samples);
+		return detail::average_chunks<Policy>(std::ranges::size(samples), options,
+			[&](auto& accumulator, std::size_t n) { accumulator.add(detail::rebind_to<compute_t>(first[n])); });
+	}
+
+	template<detail::is_precision Policy, detail::quat_samples Samples, std::ranges::random_access_range Weights>
+	requires std::convertible_to<std::ranges::range_value_t<Weights>, typename Policy::compute_type>
+	auto average(Samples const& samples, Weights const& weights, batch_options const& options = {})
+	{
+		assert(std::ranges::size(samples) == std::ranges::size(weights));
+		using compute_t = typename Policy::compute_type;
+		auto const first = std::ranges::begin(samples);
+		auto const first_weight = std::ranges::begin(weights);
+		return detail::average_chunks<Policy>(std::ranges::size(samples), options,
+			[&](auto& accumulator, std::size_t n) { accumulator.add(detail::rebind_to<compute_t>(first[n]), static_cast<compute_t>(first_weight[n])); });
+	}
+
+	template<detail::quat_samples Samples, typename T = typename std::ranges::range_value_t<Samples>::value_type>
+	quat_average<T> average(Samples const& samples, batch_options const& options = {})
+	{
+		return average<precision<T>>(samples, options);
+	}
+
+	template<detail::quat_samples Samples, std::ranges::random_access_range Weights,
+		typename T = typename std::ranges::range_value_t<Samples>::value_type>
+	requires std::convertible_to<std::ranges::range_value_t<Weights>, T>
+	quat_average<T> average(Samples const& samples, Weights const& weights, batch_options const& options = {})
+	{
+		return average<precision<T>>(samples, weights, options);
+	}
+
+} // namespace ijk
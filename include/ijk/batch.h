@@ -0,0 +1,445 @@
+#pragma once
+
+#include "quat.h"
+#include "vector.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ranges>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+
+namespace ijk {
+
+	// Long lived helper threads for the batch functions, so that a batch call does not start threads
+	// or allocate. A job is a number of chunks that the caller and the helpers it was given claim one
+	// at a time from a shared counter, a thread that gets descheduled or lands on a slow core does not
+	// hold up the rest. Helpers not given a job stay asleep.
+	// One job runs at a time, concurrent callers wait for each other and a batch call from inside a
+	// job, on this pool or any other, runs on the thread that makes it. Handing work from one pool's
+	// job to another could come back round to a pool whose job is waiting, and deadlock.
+	class thread_pool
+	{
+		struct alignas(64) helper
+		{
+			std::atomic<std::uint64_t> job{ 0 }; // last job handed to this helper, 0 while idle
+		};
+
+		// Bare function and context rather than std::function, handing out a job does not allocate
+		void (*run_chunk)(void const*, std::size_t) = nullptr;
+		void const* context = nullptr;
+		std::size_t chunk_count = 0;
+		alignas(64) std::atomic<std::size_t> next_chunk{ 0 };
+		alignas(64) std::atomic<unsigned> running{ 0 };
+
+		std::mutex submit;
+		std::uint64_t job_count = 0;
+		bool stopping = false;
+		std::unique_ptr<helper[]> helpers;
+		std::vector<std::jthread> threads;
+
+		// Set on a thread while it runs chunks of a job of any pool
+		static inline thread_local bool in_job = false;
+
+	public:
+		// helper_count threads besides the calling one, 0 means std::thread::hardware_concurrency() - 1
+		explicit thread_pool(unsigned helper_count = 0)
+		{
+			if (helper_count == 0)
+			{
+				helper_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+			}
+			helpers = std::make_unique<helper[]>(helper_count);
+			threads.reserve(helper_count);
+			for (unsigned n = 0; n < helper_count; ++n)
+			{
+				threads.emplace_back([this, n] { work(helpers[n]); });
+			}
+		}
+
+		thread_pool(thread_pool const&) = delete;
+		thread_pool& operator=(thread_pool const&) = delete;
+
+		~thread_pool()
+		{
+			std::lock_guard lock{ submit };
+			stopping = true;
+			for (std::size_t n = 0; n < threads.size(); ++n)
+			{
+				helpers[n].job.store(++job_count, std::memory_order_release);
+				helpers[n].job.notify_one();
+			}
+		}
+
+		// Helper threads, not counting callers
+		unsigned size() const noexcept
+		{
+			return static_cast<unsigned>(threads.size());
+		}
+
+		// The pool batch calls use unless batch_options name another, started on first use
+		static thread_pool& shared()
+		{
+			static thread_pool pool;
+			return pool;
+		}
+
+		// Calls f(chunk) for every chunk in [0, chunks) on the calling thread and up to helper_count helpers.
+		// An exception from f ends the program when it is thrown on a helper, as on any other thread.
+		template<typename F>
+		void run(std::size_t chunks, unsigned helper_count, F const& f)
+		{
+			helper_count = static_cast<unsigned>(std::min<std::size_t>({ helper_count, threads.size(), chunks > 0 ? chunks - 1 : 0 }));
+			if (helper_count == 0 || in_job)
+			{
+				for (std::size_t chunk = 0; chunk < chunks; ++chunk)
+				{
+					f(chunk);
+				}
+				return;
+			}
+
+			std::lock_guard lock{ submit };
+			run_chunk = [](void const* erased, std::size_t chunk) { (*static_cast<F const*>(erased))(chunk); };
+			context = &f;
+			chunk_count = chunks;
+			next_chunk.store(0, std::memory_order_relaxed);
+			running.store(helper_count, std::memory_order_relaxed);
+			++job_count;
+			for (unsigned n = 0; n < helper_count; ++n)
+			{
+				helpers[n].job.store(job_count, std::memory_order_release);
+				helpers[n].job.notify_one();
+			}
+
+			// Helpers use f until they are done, wait for them even if f throws here
+			struct wait_for_helpers
+			{
+				thread_pool& pool;
+				bool outer = in_job;
+
+				~wait_for_helpers()
+				{
+					in_job = outer;
+					for (auto left = pool.running.load(std::memory_order_acquire); left != 0; left = pool.running.load(std::memory_order_acquire))
+					{
+						pool.running.wait(left, std::memory_order_acquire);
+					}
+				}
+			} const wait{ *this };
+			in_job = true;
+			drain();
+		}
+
+	private:
+		void drain()
+		{
+			for (auto chunk = next_chunk.fetch_add(1, std::memory_order_relaxed); chunk < chunk_count;
+				chunk = next_chunk.fetch_add(1, std::memory_order_relaxed))
+			{
+				run_chunk(context, chunk);
+			}
+		}
+
+		void work(helper& self)
+		{
+			in_job = true;
+			std::uint64_t seen = 0;
+			for (;;)
+			{
+				self.job.wait(seen, std::memory_order_acquire);
+				seen = self.job.load(std::memory_order_acquire);
+				if (stopping)
+				{
+					return;
+				}
+				drain();
+				if (running.fetch_sub(1, std::memory_order_acq_rel) == 1)
+				{
+					running.notify_one();
+				}
+			}
+		}
+	};
+
+	struct batch_options
+	{
+		// Points handled per unit of work, the default keeps one chunk of vector<double> within L2
+		std::size_t chunk_size = 1 << 14;
+		// 0 means std::thread::hardware_concurrency(), at most one more than the pool has helpers
+		unsigned thread_count = 0;
+		// nullptr means thread_pool::shared()
+		thread_pool* pool = nullptr;
+	};
+
+	// Structure of arrays view of vectors, one span per direction.
+	template<typename T>
+	struct vector_soa_span
+	{
+		std::span<T> x;
+		std::span<T> y;
+		std::span<T> z;
+
+		constexpr std::size_t size() const
+		{
+			assert(x.size() == y.size() && y.size() == z.size());
+			return x.size();
+		}
+
+		constexpr operator vector_soa_span<T const>() const
+		{
+			return { x, y, z };
+		}
+	};
+
+	namespace detail
+	{
+		inline unsigned resolve_thread_count(batch_options const& options, std::size_t chunk_count)
+		{
+			unsigned threads = options.thread_count ? options.thread_count : std::thread::hardware_concurrency();
+			threads = std::max(threads, 1u);
+			return static_cast<unsigned>(std::min<std::size_t>(threads, chunk_count));
+		}
+
+		// Calls f(begin, end) for consecutive chunks of [0, count), on the pool from options.
+		template<typename F>
+		void parallel_chunks(std::size_t count, batch_options const& options, F const& f)
+		{
+			auto const chunk_size = std::max<std::size_t>(options.chunk_size, 1);
+			auto const chunk_count = (count + chunk_size - 1) / chunk_size;
+			auto const thread_count = resolve_thread_count(options, chunk_count);
+
+			auto const chunk = [&](std::size_t n)
+				{
+					auto const begin = n * chunk_size;
+					f(begin, std::min(begin + chunk_size, count));
+				};
+			if (thread_count <= 1)
+			{
+				for (std::size_t n = 0; n < chunk_count; ++n)
+				{
+					chunk(n);
+				}
+				return;
+			}
+			auto& pool = options.pool ? *options.pool : thread_pool::shared();
+			pool.run(chunk_count, thread_count - 1, chunk);
+		}
+
+		// rotate(q, v) + translation spelled out on plain components with q hoisted out of the loop.
+		// The typed version builds a vector for every intermediate, which the optimiser
+		// does not fully see through, this one runs about three times faster in batches.
+		template<typename T>
+		struct rigid_kernel
+		{
+			T w, x, y, z;
+			T tx, ty, tz;
+
+			constexpr rigid_kernel(quat<T> const& q, vector<T> const& translation)
+				: w(q.w), x(q.i.value()), y(q.j.value()), z(q.k.value())
+				, tx(translation.x.value()), ty(translation.y.value()), tz(translation.z.value())
+			{
+			}
+
+			// Rotation alone, the translation is not added
+			constexpr void rotated(T const px, T const py, T const pz, T& ox, T& oy, T& oz) const
+			{
+				// t = 2(u x p)
+				T const cx = 2 * (y * pz - z * py);
+				T const cy = 2 * (z * px - x * pz);
+				T const cz = 2 * (x * py - y * px);
+				// p + wt + u x t
+				ox = px + w * cx + (y * cz - z * cy);
+				oy = py + w * cy + (z * cx - x * cz);
+				oz = pz + w * cz + (x * cy - y * cx);
+			}
+
+			constexpr void operator()(T const px, T const py, T const pz, T& ox, T& oy, T& oz) const
+			{
+				rotated(px, py, pz, ox, oy, oz);
+				ox += tx;
+				oy += ty;
+				oz += tz;
+			}
+
+			constexpr vector<T> rotated(vector<T> const& p) const
+			{
+				T ox, oy, oz;
+				rotated(p.x.value(), p.y.value(), p.z.value(), ox, oy, oz);
+				return make_vector(ox, oy, oz);
+			}
+
+			constexpr vector<T> operator()(vector<T> const& p) const
+			{
+				T ox, oy, oz;
+				(*this)(p.x.value(), p.y.value(), p.z.value(), ox, oy, oz);
+				return make_vector(ox, oy, oz);
+			}
+
+		private:
+			static constexpr vector<T> make_vector(T ox, T oy, T oz)
+			{
+				vector<T> result;
+				result.x = I{ ox };
+				result.y = J{ oy };
+				result.z = K{ oz };
+				return result;
+			}
+		};
+	}
+
+	// Batch rigid transforms: every point is rotated by q and then translated.
+	// out may be the same span as in for an in place transform, other overlap is not allowed.
+
+	template<std::floating_point T>
+	void transform(quat<T> const& q, vector<T> const& translation,
+		std::type_identity_t<std::span<vector<T> const>> in, std::type_identity_t<std::span<vector<T>>> out, batch_options const& options = {})
+	{
+		assert(in.size() == out.size());
+		detail::rigid_kernel<T> const kernel{ q, translation };
+		detail::parallel_chunks(in.size(), options, [&](std::size_t begin, std::size_t end)
+			{
+				for (auto n = begin; n < end; ++n)
+				{
+					out[n] = kernel(in[n]);
+				}
+			});
+	}
+
+	template<std::floating_point T>
+	void transform(quat<T> const& q, vector<T> const& translation,
+		std::type_identity_t<vector_soa_span<T const>> in, std::type_identity_t<vector_soa_span<T>> out, batch_options const& options = {})
+	{
+		assert(in.size() == out.size());
+		detail::rigid_kernel<T> const kernel{ q, translation };
+		detail::parallel_chunks(in.size(), options, [&](std::size_t begin, std::size_t end)
+			{
+				for (auto n = begin; n < end; ++n)
+				{
+					kernel(in.x[n], in.y[n], in.z[n], out.x[n], out.y[n], out.z[n]);
+				}
+			});
+	}
+
+	template<std::floating_point T>
+	void transform(quat<T> const& q, vector<T> const& translation,
+		std::type_identity_t<std::span<vector<T>>> points, batch_options const& options = {})
+	{
+		transform(q, translation, std::span<vector<T> const>{ points }, points, options);
+	}
+
+	template<std::floating_point T>
+	void transform(quat<T> const& q, vector<T> const& translation,
+		std::type_identity_t<vector_soa_span<T>> points, batch_options const& options = {})
+	{
+		transform(q, translation, vector_soa_span<T const>{ points.x, points.y, points.z }, points, options);
+	}
+
+	// Batch rotations are transforms without translation
+
+	template<std::floating_point T>
+	void rotate(quat<T> const& q,
+		std::type_identity_t<std::span<vector<T> const>> in, std::type_identity_t<std::span<vector<T>>> out, batch_options const& options = {})
+	{
+		transform(q, vector<T>{}, in, out, options);
+	}
+
+	template<std::floating_point T>
+	void rotate(quat<T> const& q,
+		std::type_identity_t<vector_soa_span<T const>> in, std::type_identity_t<vector_soa_span<T>> out, batch_options const& options = {})
+	{
+		transform(q, vector<T>{}, in, out, options);
+	}
+
+	template<std::floating_point T>
+	void rotate(quat<T> const& q, std::type_identity_t<std::span<vector<T>>> points, batch_options const& options = {})
+	{
+		transform(q, vector<T>{}, points, options);
+	}
+
+	template<std::floating_point T>
+	void rotate(quat<T> const& q, std::type_identity_t<vector_soa_span<T>> points, batch_options const& options = {})
+	{
+		transform(q, vector<T>{}, points, options);
+	}
+
+	namespace detail
+	{
+		// Calls f(kernel, begin, end) for each run of [0, count) within a chunk that shares one segment's rotation
+		template<typename Rotations, typename T, typename F>
+		void parallel_segments(Rotations const& rotations, std::size_t segment_length, std::size_t count, batch_options const& options, F const& f)
+		{
+			assert(segment_length > 0 && std::ranges::size(rotations) * segment_length >= count);
+			parallel_chunks(count, options, [&](std::size_t begin, std::size_t end)
+				{
+					for (auto n = begin; n < end;)
+					{
+						auto const segment = n / segment_length;
+						auto const segment_end = std::min(end, (segment + 1) * segment_length);
+						f(rigid_kernel<T>{ std::ranges::data(rotations)[segment], vector<T>{} }, n, segment_end);
+						n = segment_end;
+					}
+				});
+		}
+	}
+
+	// Point n is rotated by rotations[n / segment_length], e.g. one orientation per scan line.
+	// As with transform out may be the same as in.
+
+	template<std::ranges::contiguous_range Rotations, typename T = typename std::ranges::range_value_t<Rotations>::value_type>
+	requires detail::is_quat<std::ranges::range_value_t<Rotations>>
+	void rotate_segments(Rotations const& rotations, std::size_t segment_length,
+		std::type_identity_t<std::span<vector<T> const>> in, std::type_identity_t<std::span<vector<T>>> out, batch_options const& options = {})
+	{
+		assert(in.size() == out.size());
+		detail::parallel_segments<Rotations, T>(rotations, segment_length, in.size(), options,
+			[&](detail::rigid_kernel<T> const& kernel, std::size_t begin, std::size_t end)
+			{
+				for (auto n = begin; n < end; ++n)
+				{
+					out[n] = kernel.rotated(in[n]);
+				}
+			});
+	}
+
+	template<std::ranges::contiguous_range Rotations, typename T = typename std::ranges::range_value_t<Rotations>::value_type>
+	requires detail::is_quat<std::ranges::range_value_t<Rotations>>
+	void rotate_segments(Rotations const& rotations, std::size_t segment_length,
+		std::type_identity_t<vector_soa_span<T const>> in, std::type_identity_t<vector_soa_span<T>> out, batch_options const& options = {})
+	{
+		assert(in.size() == out.size());
+		detail::parallel_segments<Rotations, T>(rotations, segment_length, in.size(), options,
+			[&](detail::rigid_kernel<T> const& kernel, std::size_t begin, std::size_t end)
+			{
+				for (auto n = begin; n < end; ++n)
+				{
+					kernel.rotated(in.x[n], in.y[n], in.z[n], out.x[n], out.y[n], out.z[n]);
+				}
+			});
+	}
+
+	template<std::ranges::contiguous_range Rotations, typename T = typename std::ranges::range_value_t<Rotations>::value_type>
+	requires detail::is_quat<std::ranges::range_value_t<Rotations>>
+	void rotate_segments(Rotations const& rotations, std::size_t segment_length,
+		std::type_identity_t<std::span<vector<T>>> points, batch_options const& options = {})
+	{
+		rotate_segments(rotations, segment_length, std::span<vector<T> const>{ points }, points, options);
+	}
+
+	template<std::ranges::contiguous_range Rotations, typename T = typename std::ranges::range_value_t<Rotations>::value_type>
+	requires detail::is_quat<std::ranges::range_value_t<Rotations>>
+	void rotate_segments(Rotations const& rotations, std::size_t segment_length,
+		std::type_identity_t<vector_soa_span<T>> points, batch_options const& options = {})
+	{
+		rotate_segments(rotations, segment_length, vector_soa_span<T const>{ points.x, points.y, points.z }, points, options);
+	}
+
+} // namespace ijk
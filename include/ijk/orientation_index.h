@@ -0,0 +1,463 @@
+#pragma once
+
+#include "quat.h"
+#include "batch.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <numbers>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace ijk {
+
+	template<std::floating_point T>
+	struct neighbour
+	{
+		// Position of the match in the quaternions the index was built from
+		std::size_t index;
+		// Rotation angle between query and match in radians, 0 to pi
+		T angle;
+
+		auto operator<=>(neighbour const&) const = default;
+	};
+
+	namespace detail
+	{
+		// Distance between orientations, q and -q are the same point.
+		// min(|a - b|, |a + b|) is 2 sin(angle / 4) which is a metric and, unlike anything going
+		// through the dot product, keeps its precision for small angles.
+		template<typename T>
+		T orientation_chord(std::array<T, 4> const& a, std::array<T, 4> const& b)
+		{
+			T minus = 0;
+			T plus = 0;
+			for (std::size_t n = 0; n < 4; ++n)
+			{
+				minus += (a[n] - b[n]) * (a[n] - b[n]);
+				plus += (a[n] + b[n]) * (a[n] + b[n]);
+			}
+			return std::sqrt(std::min(minus, plus));
+		}
+
+		template<typename T>
+		T chord_to_angle(T chord)
+		{
+			return 4 * std::asin(std::min(chord / 2, T{ 1 }));
+		}
+
+		template<typename T>
+		T angle_to_chord(T angle)
+		{
+			return 2 * std::sin(std::clamp(angle, T{ 0 }, std::numbers::pi_v<T>) / 4);
+		}
+
+		template<typename T>
+		std::array<T, 4> components(quat<T> const& q)
+		{
+			return { q.w, q.i.value(), q.j.value(), q.k.value() };
+		}
+	}
+
+	// Vantage point tree over unit quaternions for k nearest and radius queries by rotation angle.
+	// The tree is implicit: a node is a range of the reordered points with its vantage point first,
+	// the closer half of the rest next and the farther half last, so the only per node data is the
+	// radius splitting the halves. Small ranges are leaves that are scanned.
+	template<std::floating_point T>
+	class orientation_index
+	{
+		static constexpr std::size_t leaf_size = 16;
+		static constexpr std::uint32_t magic = 0x766b6a69; // "ijkv"
+		static constexpr std::uint32_t format_version = 1;
+
+		std::vector<std::array<T, 4>> points;
+		std::vector<std::uint32_t> ids;
+		std::vector<T> radii; // chord splitting inner and outer half, set at the vantage point of each node
+
+	public:
+		using value_type = T;
+
+		orientation_index() = default;
+
+		// The levels near the root are split on the calling thread, the subtrees below them are then
+		// built as one batch on the pool from options. Ids are 32 bit, more orientations throw length_error.
+		explicit orientation_index(std::span<quat<T> const> orientations, batch_options const& options = {})
+		{
+			if (orientations.size() > std::numeric_limits<std::uint32_t>::max())
+			{
+				throw std::length_error{ "orientation_index: more than 2^32 - 1 orientations" };
+			}
+			points.reserve(orientations.size());
+			ids.reserve(orientations.size());
+			for (std::size_t n = 0; n < orientations.size(); ++n)
+			{
+				points.push_back(detail::components(orientations[n]));
+				ids.push_back(static_cast<std::uint32_t>(n));
+			}
+			radii.resize(points.size());
+
+			// Nodes cover disjoint ranges, so one scratch array of chords serves every node on every thread
+			std::vector<T> chords(points.size());
+			auto const threads = detail::resolve_thread_count(options, points.size());
+			std::vector<std::pair<std::size_t, std::size_t>> subtrees{ { 0, points.size() } };
+			// A few subtrees per thread, so that threads finishing early pick up more
+			while (threads > 1 && subtrees.size() < 4 * threads)
+			{
+				std::vector<std::pair<std::size_t, std::size_t>> next;
+				for (auto const& [begin, end] : subtrees)
+				{
+					if (end - begin <= leaf_size)
+					{
+						next.emplace_back(begin, end);
+						continue;
+					}
+					auto const middle = partition(begin, end, chords);
+					next.emplace_back(begin + 1, middle);
+					next.emplace_back(middle, end);
+				}
+				if (next.size() == subtrees.size())
+				{
+					break;
+				}
+				subtrees = std::move(next);
+			}
+			detail::parallel_chunks(subtrees.size(), { 1, threads, options.pool }, [&](std::size_t first, std::size_t last)
+				{
+					for (auto n = first; n < last; ++n)
+					{
+						build(subtrees[n].first, subtrees[n].second, chords);
+					}
+				});
+		}
+
+		std::size_t size() const
+		{
+			return points.size();
+		}
+
+		// Up to k matches, closest first
+		std::vector<neighbour<T>> nearest(quat<T> const& query, std::size_t k) const
+		{
+			std::vector<candidate> heap;
+			heap.reserve(std::min(k, size()) + 1);
+			if (k > 0)
+			{
+				search_nearest(detail::components(query), k, 0, points.size(), heap);
+			}
+			std::sort_heap(heap.begin(), heap.end());
+			return to_neighbours(heap);
+		}
+
+		// All matches within angle radians, closest first
+		std::vector<neighbour<T>> within(quat<T> const& query, T angle) const
+		{
+			std::vector<candidate> found;
+			search_within(detail::components(query), detail::angle_to_chord(angle), 0, points.size(), found);
+			std::sort(found.begin(), found.end());
+			return to_neighbours(found);
+		}
+
+		// Batched queries: options.chunk_size counts points elsewhere, a query costs far more than
+		// transforming a point so chunks here are 256 times smaller.
+
+		// k matches per query written to out[n * k, (n + 1) * k), closest first.
+		// Slots without a match, when the index has fewer than k points, get index size() and angle infinity.
+		void nearest(std::span<quat<T> const> queries, std::size_t k, std::span<neighbour<T>> out, batch_options const& options = {}) const
+		{
+			assert(out.size() == queries.size() * k);
+			detail::parallel_chunks(queries.size(), query_options(options), [&](std::size_t begin, std::size_t end)
+				{
+					for (auto n = begin; n < end; ++n)
+					{
+						auto const found = nearest(queries[n], k);
+						auto const slots = out.subspan(n * k, k);
+						std::ranges::copy(found, slots.begin());
+						std::ranges::fill(slots.subspan(found.size()), neighbour<T>{ size(), std::numeric_limits<T>::infinity() });
+					}
+				});
+		}
+
+		std::vector<std::vector<neighbour<T>>> within(std::span<quat<T> const> queries, T angle, batch_options const& options = {}) const
+		{
+			std::vector<std::vector<neighbour<T>>> results(queries.size());
+			detail::parallel_chunks(queries.size(), query_options(options), [&](std::size_t begin, std::size_t end)
+				{
+					for (auto n = begin; n < end; ++n)
+					{
+						results[n] = within(queries[n], angle);
+					}
+				});
+			return results;
+		}
+
+		// Flat host endian copy of the built tree, loading it back skips the build.
+		std::vector<std::byte> serialize() const
+		{
+			header const head{ magic, format_version, sizeof(T), leaf_size, points.size() };
+			std::vector<std::byte> bytes(serialized_size(points.size()));
+			auto* out = bytes.data();
+			out = write(out, std::span{ &head, 1 });
+			out = write(out, std::span{ points });
+			out = write(out, std::span{ ids });
+			write(out, std::span{ radii });
+			return bytes;
+		}
+
+		// Empty if the bytes were not written by serialize for this value type.
+		static std::optional<orientation_index> deserialize(std::span<std::byte const> bytes)
+		{
+			header head;
+			if (bytes.size() < sizeof(head))
+			{
+				return std::nullopt;
+			}
+			std::memcpy(&head, bytes.data(), sizeof(head));
+			// count is checked against the bytes present before it is multiplied, a crafted count must not wrap
+			if (head.magic != magic || head.version != format_version || head.value_size != sizeof(T) || head.leaf_size != leaf_size
+				|| head.count > (bytes.size() - sizeof(head)) / bytes_per_point || bytes.size() != serialized_size(head.count))
+			{
+				return std::nullopt;
+			}
+
+			orientation_index index;
+			index.points.resize(head.count);
+			index.ids.resize(head.count);
+			index.radii.resize(head.count);
+			bytes = bytes.subspan(sizeof(head));
+			bytes = extract(bytes, std::span{ index.points });
+			bytes = extract(bytes, std::span{ index.ids });
+			extract(bytes, std::span{ index.radii });
+			// Ids are handed back as positions in the caller's orientations
+			if (std::ranges::any_of(index.ids, [&](std::uint32_t id) { return id >= head.count; }))
+			{
+				return std::nullopt;
+			}
+			return index;
+		}
+
+	private:
+		struct header
+		{
+			std::uint32_t magic;
+			std::uint32_t version;
+			std::uint32_t value_size;
+			std::uint32_t leaf_size;
+			std::uint64_t count;
+		};
+
+		struct candidate
+		{
+			T chord;
+			std::uint32_t id;
+
+			auto operator<=>(candidate const&) const = default;
+		};
+
+		static batch_options query_options(batch_options const& options)
+		{
+			return { std::max<std::size_t>(options.chunk_size / 256, 1), options.thread_count, options.pool };
+		}
+
+		static constexpr std::size_t bytes_per_point = sizeof(std::array<T, 4>) + sizeof(std::uint32_t) + sizeof(T);
+
+		static constexpr std::size_t serialized_size(std::size_t count)
+		{
+			return sizeof(header) + count * bytes_per_point;
+		}
+
+		template<typename U, std::size_t Extent>
+		static std::byte* write(std::byte* out, std::span<U, Extent> values)
+		{
+			std::memcpy(out, values.data(), values.size_bytes());
+			return out + values.size_bytes();
+		}
+
+		template<typename U>
+		static std::span<std::byte const> extract(std::span<std::byte const> bytes, std::span<U> values)
+		{
+			std::memcpy(values.data(), bytes.data(), values.size_bytes());
+			return bytes.subspan(values.size_bytes());
+		}
+
+		static constexpr std::size_t split(std::size_t begin, std::size_t end)
+		{
+			return begin + 1 + (end - begin - 1) / 2;
+		}
+
+		void swap_points(std::size_t a, std::size_t b)
+		{
+			std::swap(points[a], points[b]);
+			std::swap(ids[a], ids[b]);
+		}
+
+		void swap_entries(std::size_t a, std::size_t b, std::span<T> chords)
+		{
+			swap_points(a, b);
+			std::swap(chords[a], chords[b]);
+		}
+
+		// Quickselect on the chords carrying points and ids along: afterwards nth holds the entry
+		// it would hold if [first, last) were sorted, with no larger chord before and no smaller after.
+		// The partition is three way so libraries with many duplicate orientations stay linear.
+		void select(std::size_t first, std::size_t last, std::size_t nth, std::span<T> chords)
+		{
+			while (last - first > 1)
+			{
+				auto const middle = first + (last - first) / 2;
+				auto const pivot = std::max(std::min(chords[first], chords[middle]), std::min(std::max(chords[first], chords[middle]), chords[last - 1]));
+				auto less = first;
+				auto greater = last;
+				for (auto n = first; n < greater;)
+				{
+					if (chords[n] < pivot)
+					{
+						swap_entries(n++, less++, chords);
+					}
+					else if (pivot < chords[n])
+					{
+						swap_entries(n, --greater, chords);
+					}
+					else
+					{
+						++n;
+					}
+				}
+				if (nth < less)
+				{
+					last = less;
+				}
+				else if (nth >= greater)
+				{
+					first = greater;
+				}
+				else
+				{
+					return;
+				}
+			}
+		}
+
+		// Splits a node in place, returns where its outer half starts
+		std::size_t partition(std::size_t begin, std::size_t end, std::span<T> chords)
+		{
+			swap_points(begin, begin + (end - begin) / 2);
+			auto const vantage = points[begin];
+			for (auto n = begin + 1; n < end; ++n)
+			{
+				chords[n] = detail::orientation_chord(vantage, points[n]);
+			}
+			auto const middle = split(begin, end);
+			select(begin + 1, end, middle, chords);
+			radii[begin] = chords[middle];
+			return middle;
+		}
+
+		void build(std::size_t begin, std::size_t end, std::span<T> chords)
+		{
+			if (end - begin <= leaf_size)
+			{
+				return;
+			}
+			auto const middle = partition(begin, end, chords);
+			build(begin + 1, middle, chords);
+			build(middle, end, chords);
+		}
+
+		void search_nearest(std::array<T, 4> const& query, std::size_t k, std::size_t begin, std::size_t end, std::vector<candidate>& heap) const
+		{
+			auto consider = [&](std::size_t n)
+				{
+					candidate const c{ detail::orientation_chord(query, points[n]), ids[n] };
+					if (heap.size() < k)
+					{
+						heap.push_back(c);
+						std::push_heap(heap.begin(), heap.end());
+					}
+					else if (c < heap.front())
+					{
+						std::pop_heap(heap.begin(), heap.end());
+						heap.back() = c;
+						std::push_heap(heap.begin(), heap.end());
+					}
+				};
+			auto reach = [&]
+				{
+					return heap.size() < k ? std::numeric_limits<T>::infinity() : heap.front().chord;
+				};
+
+			if (end - begin <= leaf_size)
+			{
+				for (auto n = begin; n < end; ++n)
+				{
+					consider(n);
+				}
+				return;
+			}
+
+			auto const d = detail::orientation_chord(query, points[begin]);
+			consider(begin);
+			auto const radius = radii[begin];
+			auto const middle = split(begin, end);
+			// Descend into the half the query falls in first, it most likely tightens the reach
+			if (d <= radius)
+			{
+				if (d - radius <= reach()) search_nearest(query, k, begin + 1, middle, heap);
+				if (radius - d <= reach()) search_nearest(query, k, middle, end, heap);
+			}
+			else
+			{
+				if (radius - d <= reach()) search_nearest(query, k, middle, end, heap);
+				if (d - radius <= reach()) search_nearest(query, k, begin + 1, middle, heap);
+			}
+		}
+
+		void search_within(std::array<T, 4> const& query, T reach, std::size_t begin, std::size_t end, std::vector<candidate>& found) const
+		{
+			auto consider = [&](std::size_t n, T chord)
+				{
+					if (chord <= reach)
+					{
+						found.push_back({ chord, ids[n] });
+					}
+				};
+
+			if (end - begin <= leaf_size)
+			{
+				for (auto n = begin; n < end; ++n)
+				{
+					consider(n, detail::orientation_chord(query, points[n]));
+				}
+				return;
+			}
+
+			auto const d = detail::orientation_chord(query, points[begin]);
+			consider(begin, d);
+			auto const radius = radii[begin];
+			auto const middle = split(begin, end);
+			if (d - radius <= reach) search_within(query, reach, begin + 1, middle, found);
+			if (radius - d <= reach) search_within(query, reach, middle, end, found);
+		}
+
+		static std::vector<neighbour<T>> to_neighbours(std::vector<candidate> const& candidates)
+		{
+			std::vector<neighbour<T>> result;
+			result.reserve(candidates.size());
+			for (auto const& c : candidates)
+			{
+				result.push_back({ c.id, detail::chord_to_angle(c.chord) });
+			}
+			return result;
+		}
+	};
+
+} // namespace ijk
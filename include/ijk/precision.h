@@ -0,0 +1,311 @@
+#pragma once
+
+#include "quat.h"
+#include "complex.h"
+#include "vector.h"
+
+#include <array>
+#include <cassert>
+#include <cmath>
+#include <concepts>
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <type_traits>
+
+
+namespace ijk {
+
+	// How long sums are accumulated
+	namespace accumulation
+	{
+		// One running sum, error grows with the number of terms
+		struct plain {};
+		// Running sum that feeds the low order bits lost by each addition back into the next one,
+		// for scalar products the same with the rounding error of each multiplication
+		struct kahan {};
+		// Recursive halving, error grows with the logarithm of the number of terms, needs random access
+		struct pairwise {};
+	}
+
+	// Precision policy: values are stored as Storage, arithmetic happens in Compute and
+	// long reductions accumulate according to Accumulation.
+	// precision<float, double, accumulation::kahan> keeps float sized arrays with close to double accuracy.
+	template<std::floating_point Storage, std::floating_point Compute = Storage, typename Accumulation = accumulation::plain>
+	struct precision
+	{
+		using storage_type = Storage;
+		using compute_type = Compute;
+		using accumulation_type = Accumulation;
+	};
+
+	namespace detail
+	{
+		template<typename P>
+		concept is_precision = std::same_as<P, precision<typename P::storage_type, typename P::compute_type, typename P::accumulation_type>>;
+
+		// Same kind of value with another value type, quat<float> -> quat<double>
+		template<typename V, typename U>
+		struct rebind
+		{
+			using type = U;
+		};
+
+		template<template<std::floating_point> typename Kind, typename T, typename U>
+		struct rebind<Kind<T>, U>
+		{
+			using type = Kind<U>;
+		};
+
+		template<typename T, typename direction, typename U>
+		struct rebind<directed_value<T, direction>, U>
+		{
+			using type = directed_value<U, direction>;
+		};
+
+		template<typename V, typename U>
+		using rebind_t = typename rebind<V, U>::type;
+
+		template<typename V>
+		concept has_components = direction_or_floating<V> || is_complex<V> || is_vector<V> || is_quat<V>;
+
+		template<typename T>
+		constexpr auto component_value(T const& c)
+		{
+			if constexpr (has_direction<T>)
+			{
+				return c.value();
+			}
+			else
+			{
+				return c;
+			}
+		}
+
+		template<has_components V>
+		constexpr auto components_of(V const& v)
+		{
+			return apply([](auto const&... c) { return std::array{ component_value(c)... }; }, v);
+		}
+
+		template<has_components V>
+		constexpr std::size_t component_count = std::tuple_size_v<decltype(components_of(std::declval<V>()))>;
+
+		template<has_components V, typename T>
+		constexpr V from_components(std::array<T, component_count<V>> const& values)
+		{
+			if constexpr (has_direction<V>)
+			{
+				return V(values[0]);
+			}
+			else
+			{
+				V result{};
+				std::size_t n = 0;
+				apply([&](auto&... c) { ((c = std::remove_cvref_t<decltype(c)>(values[n++])), ...); }, result);
+				return result;
+			}
+		}
+
+		template<std::floating_point U, has_components V>
+		constexpr rebind_t<V, U> rebind_to(V const& v)
+		{
+			auto const values = components_of(v);
+			std::array<U, values.size()> converted{};
+			for (std::size_t n = 0; n < values.size(); ++n)
+			{
+				converted[n] = static_cast<U>(values[n]);
+			}
+			return from_components<rebind_t<V, U>>(converted);
+		}
+
+		template<typename T, typename Accumulation>
+		struct accumulator
+		{
+			T sum{ 0 };
+
+			constexpr void add(T x)
+			{
+				sum += x;
+			}
+
+			constexpr void merge(accumulator const& other)
+			{
+				sum += other.sum;
+			}
+
+			constexpr T value() const
+			{
+				return sum;
+			}
+		};
+
+		template<typename T>
+		struct accumulator<T, accumulation::kahan>
+		{
+			T sum{ 0 };
+			T compensation{ 0 }; // low order bits lost so far, negated
+
+			constexpr void add(T x)
+			{
+				T const corrected = x - compensation;
+				T const next = sum + corrected;
+				compensation = (next - sum) - corrected;
+				sum = next;
+			}
+
+			constexpr void merge(accumulator const& other)
+			{
+				add(other.value());
+			}
+
+			constexpr T value() const
+			{
+				return sum - compensation;
+			}
+		};
+
+		// Pairwise is a property of the traversal, streaming accumulators fall back to plain
+		template<typename T>
+		struct accumulator<T, accumulation::pairwise> : accumulator<T, accumulation::plain> {};
+
+		// One pass from first to last, except pairwise which needs random access to split the range
+		template<typename Compute, typename Accumulation, typename It, typename S>
+		constexpr auto accumulate_components(It first, S last) -> std::array<Compute, component_count<std::iter_value_t<It>>>
+		{
+			constexpr auto N = component_count<std::iter_value_t<It>>;
+
+			if constexpr (std::same_as<Accumulation, accumulation::pairwise>)
+			{
+				// Below this plain summation is as good and avoids the recursion overhead
+				constexpr std::iter_difference_t<It> block = 8;
+				if (auto const count = std::ranges::distance(first, last); count > block)
+				{
+					auto const middle = first + count / 2;
+					auto left = accumulate_components<Compute, Accumulation>(first, middle);
+					auto const right = accumulate_components<Compute, Accumulation>(middle, last);
+					for (std::size_t n = 0; n < N; ++n)
+					{
+						left[n] += right[n];
+					}
+					return left;
+				}
+			}
+
+			std::array<accumulator<Compute, Accumulation>, N> sums{};
+			for (; first != last; ++first)
+			{
+				auto const values = components_of(*first);
+				for (std::size_t n = 0; n < N; ++n)
+				{
+					sums[n].add(static_cast<Compute>(values[n]));
+				}
+			}
+			std::array<Compute, N> result{};
+			for (std::size_t n = 0; n < N; ++n)
+			{
+				result[n] = sums[n].value();
+			}
+			return result;
+		}
+
+		template<typename Compute, typename Accumulation, typename It, typename S>
+		constexpr auto multiply_range(It first, S last) -> rebind_t<std::iter_value_t<It>, Compute>
+		{
+			using compute_value_t = rebind_t<std::iter_value_t<It>, Compute>;
+
+			if constexpr (std::same_as<Accumulation, accumulation::pairwise>)
+			{
+				if (auto const count = std::ranges::distance(first, last); count > 2)
+				{
+					auto const middle = first + count / 2;
+					return multiply_range<Compute, Accumulation>(first, middle) * multiply_range<Compute, Accumulation>(middle, last);
+				}
+			}
+			else if constexpr (std::same_as<Accumulation, accumulation::kahan>)
+			{
+				// Compensated product of scalars, Graillat's CompProd: fma recovers the exact rounding
+				// error of each multiplication and the errors are carried along in a second product
+				static_assert(std::floating_point<compute_value_t>, "compensated products are only defined for scalars");
+				Compute product{ 1 };
+				Compute error{ 0 };
+				for (; first != last; ++first)
+				{
+					auto const factor = static_cast<Compute>(*first);
+					auto const rounded = product * factor;
+					error = error * factor + std::fma(product, factor, -rounded);
+					product = rounded;
+				}
+				return product + error;
+			}
+
+			compute_value_t product{ Compute{ 1 } };
+			for (; first != last; ++first)
+			{
+				product = product * rebind_to<Compute>(*first);
+			}
+			return product;
+		}
+
+		template<typename R, typename Accumulation>
+		concept accumulable_range = std::ranges::input_range<R>
+			&& (!std::same_as<Accumulation, accumulation::pairwise> || (std::ranges::random_access_range<R> && std::ranges::sized_range<R>));
+	}
+
+	// Policy tagged arithmetic: operands are widened to the compute type, combined with the
+	// ordinary operators and the result narrowed to the storage type. Unlike the operators
+	// the result type does not follow std::common_type, add<precision<float, double>>(1_jf, 1_jl) is float.
+
+	template<detail::is_precision Policy, typename T, typename U>
+	requires detail::has_components<T> && detail::has_components<U>
+	constexpr auto add(T const& LHS, U const& RHS)
+	{
+		using compute_t = typename Policy::compute_type;
+		return detail::rebind_to<typename Policy::storage_type>(detail::rebind_to<compute_t>(LHS) + detail::rebind_to<compute_t>(RHS));
+	}
+
+	template<detail::is_precision Policy, typename T, typename U>
+	requires detail::has_components<T> && detail::has_components<U>
+	constexpr auto subtract(T const& LHS, U const& RHS)
+	{
+		using compute_t = typename Policy::compute_type;
+		return detail::rebind_to<typename Policy::storage_type>(detail::rebind_to<compute_t>(LHS) - detail::rebind_to<compute_t>(RHS));
+	}
+
+	template<detail::is_precision Policy, typename T, typename U>
+	requires detail::has_components<T> && detail::has_components<U>
+	constexpr auto multiply(T const& LHS, U const& RHS)
+	{
+		using compute_t = typename Policy::compute_type;
+		return detail::rebind_to<typename Policy::storage_type>(detail::rebind_to<compute_t>(LHS) * detail::rebind_to<compute_t>(RHS));
+	}
+
+	// Sum of scalars, complex numbers, vectors or quaternions.
+	// Pairwise accumulation needs a sized random access range, the others take any input range in a single pass.
+	template<detail::is_precision Policy, typename R>
+	requires detail::accumulable_range<R, typename Policy::accumulation_type> && detail::has_components<std::ranges::range_value_t<R>>
+	constexpr auto sum(R&& values)
+	{
+		using storage_value_t = detail::rebind_t<std::ranges::range_value_t<R>, typename Policy::storage_type>;
+		auto const sums = detail::accumulate_components<typename Policy::compute_type, typename Policy::accumulation_type>(
+			std::ranges::begin(values), std::ranges::end(values));
+		return detail::from_components<storage_value_t>(sums);
+	}
+
+	// Ordered product of scalars, complex numbers or quaternions, the identity for an empty range.
+	// Pairwise multiplies neighbours up a tree, which keeps error growth logarithmic for long chains.
+	// Kahan is a compensated product for scalars. There is no cheap compensated quaternion or complex
+	// product, so kahan does not compile for them, the wide compute type is what carries the accuracy there.
+	template<detail::is_precision Policy, typename R>
+	requires detail::accumulable_range<R, typename Policy::accumulation_type>
+		&& (std::floating_point<std::ranges::range_value_t<R>>
+			|| ((detail::is_complex<std::ranges::range_value_t<R>> || detail::is_quat<std::ranges::range_value_t<R>>)
+				&& !std::same_as<typename Policy::accumulation_type, accumulation::kahan>))
+	constexpr auto product(R&& values)
+	{
+		auto const result = detail::multiply_range<typename Policy::compute_type, typename Policy::accumulation_type>(
+			std::ranges::begin(values), std::ranges::end(values));
+		return detail::rebind_to<typename Policy::storage_type>(result);
+	}
+
+} // namespace ijk
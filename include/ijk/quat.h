@@ -106,4 +106,15 @@ namespace ijk {
 		return apply(apply(foiler{}, LHS), RHS);
 	}
 
+	// Rotates v by the unit quaternion q. Same as the vector part of q * v * q.conjugate()
+	// but with t = 2(u x v), v + wt + u x t where u is the vector part of q, which takes fewer multiplications.
+	template<typename T, typename U>
+	constexpr auto rotate(quat<T> const& q, vector<U> const& v)
+	{
+		using value_t = std::common_type_t<T, U>;
+		vector<value_t> const u{ q.i, q.j, q.k };
+		auto const t = value_t{ 2 } * cross(u, v);
+		return v + value_t{ q.w } * t + cross(u, t);
+	}
+
 } // namespace ijk
\ No newline at end of file
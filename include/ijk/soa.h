@@ -0,0 +1,305 @@
+#pragma once
+
+#include "quat.h"
+#include "complex.h"
+#include "vector.h"
+#include "batch.h"
+#include "precision.h"
+#include "arena.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+
+namespace ijk {
+
+	namespace detail
+	{
+		struct alignas(64) cache_line
+		{
+			std::byte bytes[64];
+		};
+
+		template<typename V>
+		concept soa_storable = is_quat<V> || is_complex<V> || is_vector<V>;
+	}
+
+	// Structure of arrays container for quat, complex or vector: one array per component.
+	// All components share a single allocation and every component array starts on a 64 byte boundary,
+	// so the spans from component() can be fed to vectorised loops without peeling.
+	// The allocator is rebound to 64 byte cache lines, any standard conforming allocator including
+	// std::pmr::polymorphic_allocator and frame_allocator gets the alignment right.
+	template<detail::soa_storable V, typename Allocator = std::allocator<V>>
+	class soa_vector
+	{
+	public:
+		using value_type = V;
+		using component_type = typename V::value_type;
+		using allocator_type = Allocator;
+		using size_type = std::size_t;
+
+		static constexpr std::size_t component_count = detail::component_count<V>;
+		static constexpr std::size_t alignment = alignof(detail::cache_line);
+
+	private:
+		using line = detail::cache_line;
+		using line_allocator = typename std::allocator_traits<Allocator>::template rebind_alloc<line>;
+		using line_traits = std::allocator_traits<line_allocator>;
+
+		static constexpr std::size_t per_line = sizeof(line) / sizeof(component_type);
+
+		[[no_unique_address]] line_allocator alloc;
+		line* lines = nullptr;
+		std::size_t count = 0;
+		std::size_t cap = 0; // per component, a whole number of lines
+
+	public:
+		soa_vector() = default;
+
+		explicit soa_vector(Allocator const& allocator)
+			: alloc(allocator)
+		{
+		}
+
+		explicit soa_vector(std::size_t size, Allocator const& allocator = Allocator{})
+			: alloc(allocator)
+		{
+			resize(size);
+		}
+
+		soa_vector(soa_vector const& other)
+			: soa_vector(other, std::allocator_traits<Allocator>::select_on_container_copy_construction(other.get_allocator()))
+		{
+		}
+
+		soa_vector(soa_vector const& other, Allocator const& allocator)
+			: alloc(allocator)
+		{
+			assign_from(other);
+		}
+
+		soa_vector(soa_vector&& other) noexcept
+			: alloc(std::move(other.alloc))
+			, lines(std::exchange(other.lines, nullptr))
+			, count(std::exchange(other.count, 0))
+			, cap(std::exchange(other.cap, 0))
+		{
+		}
+
+		soa_vector& operator=(soa_vector const& other)
+		{
+			if (this != &other)
+			{
+				if constexpr (line_traits::propagate_on_container_copy_assignment::value)
+				{
+					if (alloc != other.alloc)
+					{
+						release();
+					}
+					alloc = other.alloc;
+				}
+				assign_from(other);
+			}
+			return *this;
+		}
+
+		soa_vector& operator=(soa_vector&& other) noexcept(line_traits::propagate_on_container_move_assignment::value || line_traits::is_always_equal::value)
+		{
+			if (this == &other)
+			{
+				return *this;
+			}
+			if constexpr (line_traits::propagate_on_container_move_assignment::value)
+			{
+				release();
+				alloc = std::move(other.alloc);
+			}
+			else if (alloc != other.alloc)
+			{
+				// Memory of the other allocator cannot be adopted, copy instead
+				assign_from(other);
+				return *this;
+			}
+			else
+			{
+				release();
+			}
+			lines = std::exchange(other.lines, nullptr);
+			count = std::exchange(other.count, 0);
+			cap = std::exchange(other.cap, 0);
+			return *this;
+		}
+
+		~soa_vector()
+		{
+			release();
+		}
+
+		allocator_type get_allocator() const
+		{
+			return allocator_type(alloc);
+		}
+
+		std::size_t size() const noexcept
+		{
+			return count;
+		}
+
+		std::size_t capacity() const noexcept
+		{
+			return cap;
+		}
+
+		bool empty() const noexcept
+		{
+			return count == 0;
+		}
+
+		void reserve(std::size_t size)
+		{
+			if (size > cap)
+			{
+				reallocate(size);
+			}
+		}
+
+		// New elements are zero
+		void resize(std::size_t size)
+		{
+			reserve(size);
+			if (size > count)
+			{
+				for (std::size_t c = 0; c < component_count; ++c)
+				{
+					std::fill(data(c) + count, data(c) + size, component_type{ 0 });
+				}
+			}
+			count = size;
+		}
+
+		void clear() noexcept
+		{
+			count = 0;
+		}
+
+		void push_back(V const& value)
+		{
+			if (count == cap)
+			{
+				reallocate(std::max(cap * 2, count + 1));
+			}
+			set(count++, value);
+		}
+
+		void pop_back() noexcept
+		{
+			assert(count > 0);
+			--count;
+		}
+
+		// Elements are assembled from the component arrays, there is no V in memory to refer to
+		V operator[](std::size_t n) const
+		{
+			assert(n < count);
+			std::array<component_type, component_count> values;
+			for (std::size_t c = 0; c < component_count; ++c)
+			{
+				values[c] = data(c)[n];
+			}
+			return detail::from_components<V>(values);
+		}
+
+		void set(std::size_t n, V const& value)
+		{
+			assert(n < cap);
+			auto const values = detail::components_of(value);
+			for (std::size_t c = 0; c < component_count; ++c)
+			{
+				data(c)[n] = values[c];
+			}
+		}
+
+		// Component c in the order of the value's members, e.g. w, i, j, k for quat
+		std::span<component_type> component(std::size_t c) noexcept
+		{
+			return { data(c), count };
+		}
+
+		std::span<component_type const> component(std::size_t c) const noexcept
+		{
+			return { data(c), count };
+		}
+
+		// Vectors as the spans batch.h and attitude_filters take
+		vector_soa_span<component_type> soa() noexcept requires detail::is_vector<V>
+		{
+			return { component(0), component(1), component(2) };
+		}
+
+		vector_soa_span<component_type const> soa() const noexcept requires detail::is_vector<V>
+		{
+			return { component(0), component(1), component(2) };
+		}
+
+	private:
+		component_type* data(std::size_t c) const noexcept
+		{
+			return reinterpret_cast<component_type*>(lines) + c * cap;
+		}
+
+		void reallocate(std::size_t size)
+		{
+			auto const line_count = (size + per_line - 1) / per_line;
+			auto* const fresh = line_traits::allocate(alloc, line_count * component_count);
+			auto const fresh_cap = line_count * per_line;
+			for (std::size_t c = 0; c < component_count; ++c)
+			{
+				std::copy_n(data(c), count, reinterpret_cast<component_type*>(fresh) + c * fresh_cap);
+			}
+			auto const kept = count;
+			release();
+			lines = fresh;
+			cap = fresh_cap;
+			count = kept;
+		}
+
+		void release() noexcept
+		{
+			if (lines)
+			{
+				line_traits::deallocate(alloc, lines, cap / per_line * component_count);
+			}
+			lines = nullptr;
+			count = 0;
+			cap = 0;
+		}
+
+		void assign_from(soa_vector const& other)
+		{
+			clear();
+			reserve(other.count);
+			for (std::size_t c = 0; c < component_count; ++c)
+			{
+				std::copy_n(other.data(c), other.count, data(c));
+			}
+			count = other.count;
+		}
+	};
+
+	namespace pmr
+	{
+		template<detail::soa_storable V>
+		using soa_vector = ijk::soa_vector<V, std::pmr::polymorphic_allocator<V>>;
+	}
+
+	template<detail::soa_storable V>
+	using frame_soa_vector = soa_vector<V, frame_allocator<V>>;
+
+} // namespace ijk
@@ -92,15 +92,17 @@ namespace ijk {
 		return res;
 	}
 
-	template<std::floating_point T, detail::is_vector U>
-	constexpr auto operator*(T LHS, U RHS)
+	// Taking vector<U> rather than a constrained U makes these more specialised than the
+	// quaternion product in quat.h, so scalar times vector stays a vector when both are included.
+	template<std::floating_point T, std::floating_point U>
+	constexpr auto operator*(T LHS, vector<U> RHS)
 	{
 		detail::apply([LHS](auto&... components) {((components *= LHS), ...); }, RHS);
 		return RHS;
 	}
 
-	template<std::floating_point T, detail::is_vector U>
-	constexpr auto operator*(U LHS, T RHS)
+	template<std::floating_point T, std::floating_point U>
+	constexpr auto operator*(vector<U> LHS, T RHS)
 	{
 		return RHS * LHS;
 	}
@@ -110,4 +112,21 @@ namespace ijk {
 	{
 		return LHS * (U{ 1.0 } / RHS);
 	}
+
+	// ii == jj == kk == -1 so the sum of same direction products is the negated dot product
+	template<typename T, typename U>
+	constexpr auto dot(vector<T> const& LHS, vector<U> const& RHS)
+	{
+		return -(LHS.x * RHS.x + LHS.y * RHS.y + LHS.z * RHS.z);
+	}
+
+	// The direction identities (ij = k, ji = -k, ...) already carry the signs of the cross product
+	template<typename T, typename U>
+	constexpr auto cross(vector<T> const& LHS, vector<U> const& RHS)
+	{
+		return vector<std::common_type_t<T, U>>{
+			LHS.y * RHS.z + LHS.z * RHS.y,
+			LHS.z * RHS.x + LHS.x * RHS.z,
+			LHS.x * RHS.y + LHS.y * RHS.x };
+	}
 }
\ No newline at end of file
@@ -0,0 +1,272 @@
+#pragma once
+
+#include "quat.h"
+#include "vector.h"
+#include "batch.h"
+
+#include <concepts>
+#include <ranges>
+#include <type_traits>
+#include <utility>
+
+
+namespace ijk::views {
+
+	namespace detail
+	{
+		// a * b where either side may be known to be the identity, which is then not multiplied in
+		template<typename T>
+		constexpr quat<T> product(quat<T> const& a, bool const has_a, quat<T> const& b, bool const has_b)
+		{
+			if (has_a && has_b)
+			{
+				return a * b;
+			}
+			return has_a ? a : has_b ? b : quat<T>{ T{ 1 } };
+		}
+	}
+
+	// x -> rotation * x * rotation.conjugate() + translation for ranges of vectors.
+	// Any sequence of rotate and translate collapses into one of these.
+	// The flags say which parts are not the identity, those that are get skipped
+	// so a pure translate is just an add and infinities and signed zeros pass through.
+	template<std::floating_point T>
+	struct rigid_transform
+	{
+		quat<T> rotation{ T{ 1 } };
+		vector<T> translation{};
+		bool rotates = true;
+		bool translates = true;
+
+		constexpr vector<T> operator()(vector<T> const& v) const
+		{
+			if (!rotates)
+			{
+				return translates ? v + translation : v;
+			}
+			ijk::detail::rigid_kernel<T> const kernel{ rotation, translation };
+			return translates ? kernel(v) : kernel.rotated(v);
+		}
+	};
+
+	// x -> left * x * right, or left * x.conjugate() * right, for ranges of quaternions.
+	// Any sequence of multiply and conjugate collapses into one of these.
+	// As above the flags mark the sides that are not the identity,
+	// conjugate alone is only a sign flip and a single multiply is one product.
+	template<std::floating_point T>
+	struct quat_transform
+	{
+		quat<T> left{ T{ 1 } };
+		quat<T> right{ T{ 1 } };
+		bool conjugated = false;
+		bool multiplies_left = true;
+		bool multiplies_right = true;
+
+		constexpr quat<T> operator()(quat<T> const& q) const
+		{
+			auto const x = conjugated ? q.conjugate() : q;
+			auto const lx = multiplies_left ? left * x : x;
+			return multiplies_right ? lx * right : lx;
+		}
+	};
+
+	// Does not know its value type until it meets a range or another transform
+	struct conjugate_t {};
+	inline constexpr conjugate_t conjugate{};
+
+	template<std::floating_point T>
+	constexpr rigid_transform<T> rotate(quat<T> const& q)
+	{
+		return { q, vector<T>{}, true, false };
+	}
+
+	template<std::floating_point T>
+	constexpr rigid_transform<T> translate(vector<T> const& v)
+	{
+		return { quat<T>{ T{ 1 } }, v, false, true };
+	}
+
+	// x -> x * q
+	template<std::floating_point T>
+	constexpr quat_transform<T> multiply(quat<T> const& q)
+	{
+		return { quat<T>{ T{ 1 } }, q, false, false, true };
+	}
+
+	// Composition, first | second applies first and then second
+
+	template<std::floating_point T>
+	constexpr rigid_transform<T> operator|(rigid_transform<T> const& first, rigid_transform<T> const& second)
+	{
+		rigid_transform<T> result{
+			detail::product(second.rotation, second.rotates, first.rotation, first.rotates),
+			second.translation,
+			first.rotates || second.rotates,
+			first.translates || second.translates };
+		if (first.translates)
+		{
+			auto const moved = second.rotates ? ijk::rotate(second.rotation, first.translation) : first.translation;
+			result.translation = second.translates ? moved + second.translation : moved;
+		}
+		return result;
+	}
+
+	template<std::floating_point T>
+	constexpr quat_transform<T> operator|(quat_transform<T> const& first, quat_transform<T> const& second)
+	{
+		if (!second.conjugated)
+		{
+			return {
+				detail::product(second.left, second.multiplies_left, first.left, first.multiplies_left),
+				detail::product(first.right, first.multiplies_right, second.right, second.multiplies_right),
+				first.conjugated,
+				first.multiplies_left || second.multiplies_left,
+				first.multiplies_right || second.multiplies_right };
+		}
+		// (a f(x) b)* == b* f(x)* a*
+		return {
+			detail::product(second.left, second.multiplies_left, first.right.conjugate(), first.multiplies_right),
+			detail::product(first.left.conjugate(), first.multiplies_left, second.right, second.multiplies_right),
+			!first.conjugated,
+			first.multiplies_right || second.multiplies_left,
+			first.multiplies_left || second.multiplies_right };
+	}
+
+	template<std::floating_point T>
+	constexpr quat_transform<T> operator|(quat_transform<T> const& first, conjugate_t)
+	{
+		return first | quat_transform<T>{ quat<T>{ T{ 1 } }, quat<T>{ T{ 1 } }, true, false, false };
+	}
+
+	template<std::floating_point T>
+	constexpr quat_transform<T> operator|(conjugate_t, quat_transform<T> const& second)
+	{
+		return quat_transform<T>{ quat<T>{ T{ 1 } }, quat<T>{ T{ 1 } }, true, false, false } | second;
+	}
+
+	namespace detail
+	{
+		template<typename F>
+		struct is_transform : std::false_type {};
+
+		template<typename T>
+		struct is_transform<rigid_transform<T>> : std::true_type {};
+
+		template<typename T>
+		struct is_transform<quat_transform<T>> : std::true_type {};
+
+		template<>
+		struct is_transform<conjugate_t> : std::true_type {};
+
+		template<typename F>
+		concept transform = is_transform<F>::value;
+
+		// conjugate_t picks up the value type from the range it is applied to
+		template<typename R, typename F>
+		constexpr auto for_range(F const& f)
+		{
+			if constexpr (std::same_as<F, conjugate_t>)
+			{
+				using value_t = typename std::ranges::range_value_t<R>::value_type;
+				return quat_transform<value_t>{ quat<value_t>{ value_t{ 1 } }, quat<value_t>{ value_t{ 1 } }, false, false, false } | f;
+			}
+			else
+			{
+				return f;
+			}
+		}
+	}
+
+	// A transform_view that remembers its transform so that piping another transform
+	// into it replaces the transform with the composition instead of stacking a second view.
+	// range | rotate(q1) | rotate(q2) | translate(v) is a single view calling a single rigid_transform.
+	template<std::ranges::view V, detail::transform F>
+	class fused_view : public std::ranges::view_interface<fused_view<V, F>>
+	{
+		F fn{};
+		std::ranges::transform_view<V, F> impl{};
+
+	public:
+		fused_view() requires std::default_initializable<V> = default;
+
+		constexpr fused_view(V base, F f)
+			: fn(f)
+			, impl(std::move(base), f)
+		{
+		}
+
+		constexpr V base() const& requires std::copy_constructible<V>
+		{
+			return impl.base();
+		}
+
+		constexpr V base() &&
+		{
+			return std::move(impl).base();
+		}
+
+		constexpr F const& transform() const
+		{
+			return fn;
+		}
+
+		constexpr auto begin()
+		{
+			return impl.begin();
+		}
+
+		constexpr auto begin() const requires std::ranges::range<std::ranges::transform_view<V, F> const>
+		{
+			return impl.begin();
+		}
+
+		constexpr auto end()
+		{
+			return impl.end();
+		}
+
+		constexpr auto end() const requires std::ranges::range<std::ranges::transform_view<V, F> const>
+		{
+			return impl.end();
+		}
+
+		constexpr auto size() requires std::ranges::sized_range<V>
+		{
+			return impl.size();
+		}
+
+		constexpr auto size() const requires std::ranges::sized_range<V const>
+		{
+			return impl.size();
+		}
+	};
+
+	template<typename R, typename F>
+	fused_view(R&&, F) -> fused_view<std::views::all_t<R>, F>;
+
+	namespace detail
+	{
+		template<typename R>
+		struct is_fused_view : std::false_type {};
+
+		template<typename V, typename F>
+		struct is_fused_view<fused_view<V, F>> : std::true_type {};
+	}
+
+	template<std::ranges::viewable_range R, detail::transform F>
+	requires (!detail::is_fused_view<std::remove_cvref_t<R>>::value)
+	constexpr auto operator|(R&& range, F const& f)
+	{
+		return fused_view(std::forward<R>(range), detail::for_range<R>(f));
+	}
+
+	template<typename View, detail::transform G>
+	requires detail::is_fused_view<std::remove_cvref_t<View>>::value
+		&& requires(View&& view, G const& g) { view.transform() | g; }
+	constexpr auto operator|(View&& view, G const& g)
+	{
+		auto fused = view.transform() | g;
+		return fused_view(std::forward<View>(view).base(), fused);
+	}
+
+} // namespace ijk::views
@@ -0,0 +1,106 @@
+#include <ijk/arena.h>
+#include "expect.h"
+
+#include <cstdint>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+#include <vector>
+
+// Counts what the arena asks of the heap
+class counting_resource : public std::pmr::memory_resource
+{
+public:
+	int allocations = 0;
+	int deallocations = 0;
+
+private:
+	void* do_allocate(std::size_t bytes, std::size_t alignment) override
+	{
+		++allocations;
+		return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+	}
+
+	void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+	{
+		++deallocations;
+		std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+	}
+
+	bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override
+	{
+		return this == &other;
+	}
+};
+
+int main()
+{
+	counting_resource upstream;
+	{
+		ijk::monotonic_arena arena{ 1024, &upstream };
+		expect(upstream.allocations == 0, "nothing up front");
+
+		auto frame = [&]
+			{
+				{
+					std::pmr::vector<double> values{ &arena };
+					for (int n = 0; n < 5000; ++n)
+					{
+						values.push_back(n);
+					}
+					auto* aligned = arena.allocate(100, 64);
+					expect(reinterpret_cast<std::uintptr_t>(aligned) % 64 == 0, "alignment");
+				}
+				arena.reset();
+			};
+
+		frame();
+		auto const warm = upstream.allocations;
+		expect(warm > 0, "first frame grows");
+		for (int n = 0; n < 10; ++n)
+		{
+			frame();
+		}
+		expect(upstream.allocations == warm, "later frames reuse the blocks");
+		expect(arena.capacity() >= 5000 * sizeof(double), "capacity");
+	}
+	expect(upstream.deallocations == upstream.allocations, "blocks returned on destruction");
+
+	std::vector<int, ijk::frame_allocator<int>> per_thread{ 1, 2, 3 };
+	expect(per_thread.size() == 3 && per_thread[2] == 3, "frame allocator");
+
+	bool threw = false;
+	try
+	{
+		ijk::frame_allocator<double>{}.allocate(std::size_t{ 1 } << 62);
+	}
+	catch (std::bad_array_new_length const&)
+	{
+		threw = true;
+	}
+	expect(threw, "oversized frame allocation");
+
+	// Sizes near the limit throw instead of wrapping around in the size arithmetic
+	auto const throws_bad_alloc = [](auto&& allocate)
+		{
+			try
+			{
+				allocate();
+			}
+			catch (std::bad_alloc const&)
+			{
+				return true;
+			}
+			return false;
+		};
+	// volatile, so g++ does not reject the deliberately oversized constants at compile time
+	std::size_t volatile const size_max = SIZE_MAX;
+	ijk::monotonic_arena near_limit;
+	expect(throws_bad_alloc([&] { (void)near_limit.allocate(size_max - 32, 64); }), "arena allocation near the limit");
+	expect(throws_bad_alloc([&] { (void)near_limit.allocate(size_max / 2 + 1, 1); }), "arena block larger than half the address space");
+	expect(throws_bad_alloc([&] { ijk::frame_allocator<double>{}.allocate(size_max / 8 - 2); }), "frame allocation near the limit");
+	expect(near_limit.allocate(64, 64) != nullptr, "arena still usable");
+
+	std::cout << "arena failures: " << failures << '\n';
+	return failures;
+}
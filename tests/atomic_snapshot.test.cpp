@@ -0,0 +1,115 @@
+#include <ijk/atomic_snapshot.h>
+#include <ijk/quat.h>
+
+#include <atomic>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+using namespace ijk::literals;
+
+// Constructing a value before the checks used to make g++ 12 reject it
+static auto const constructed_first = ijk::quat<double>{ 1. } * ijk::quat<double>{ ijk::I{ 1. } };
+static_assert(ijk::detail::snapshotable<ijk::quat<double>>, "value types can be copied word by word");
+static_assert(ijk::detail::snapshotable<ijk::vector<double>>);
+static_assert(ijk::detail::snapshotable<ijk::complex<float>>);
+
+// Every component of a published value carries the same number so a torn read is visible
+static ijk::quat<double> stamped_quat(double n)
+{
+	return ijk::quat<double>{ n, ijk::I{ n }, ijk::J{ n }, ijk::K{ n } };
+}
+
+static bool is_stamped(ijk::quat<double> const& q)
+{
+	return q.i.value() == q.w && q.j.value() == q.w && q.k.value() == q.w;
+}
+
+static constexpr int store_count = 200000;
+static constexpr int reader_count = 4;
+
+static int snapshot_stress()
+{
+	ijk::atomic_snapshot<ijk::quat<double>> pose;
+	std::atomic<bool> done{ false };
+	std::atomic<int> failures{ 0 };
+
+	std::vector<std::thread> readers;
+	for (int r = 0; r < reader_count; ++r)
+	{
+		readers.emplace_back([&]
+			{
+				double last = 0;
+				while (!done.load(std::memory_order_relaxed))
+				{
+					auto const q = pose.load();
+					if (!is_stamped(q) || q.w < last)
+					{
+						++failures;
+					}
+					last = q.w;
+				}
+			});
+	}
+
+	for (int n = 1; n <= store_count; ++n)
+	{
+		pose.store(stamped_quat(n));
+	}
+	done = true;
+	for (auto& reader : readers)
+	{
+		reader.join();
+	}
+
+	if (pose.load() != stamped_quat(store_count) || pose.version() != store_count)
+	{
+		++failures;
+	}
+	return failures;
+}
+
+static int triple_buffer_stress()
+{
+	ijk::triple_buffer<ijk::quat<double>> pose{ stamped_quat(0) };
+	std::atomic<bool> done{ false };
+	int failures = 0;
+
+	std::thread reader([&]
+		{
+			double last = 0;
+			while (!done.load(std::memory_order_acquire))
+			{
+				auto const& q = pose.read();
+				if (!is_stamped(q) || q.w < last)
+				{
+					++failures;
+				}
+				last = q.w;
+			}
+			if (pose.read() != stamped_quat(store_count))
+			{
+				++failures;
+			}
+		});
+
+	for (int n = 1; n <= store_count; ++n)
+	{
+		pose.store(stamped_quat(n));
+	}
+	done.store(true, std::memory_order_release);
+	reader.join();
+	return failures;
+}
+
+int main()
+{
+	ijk::atomic_snapshot<ijk::vector<float>> position{ ijk::vector<float>{ 1_i, 2_j, 3_k } };
+	std::cout << "position: " << position.load() << '\n';
+
+	auto const snapshot_failures = snapshot_stress();
+	auto const triple_failures = triple_buffer_stress();
+	std::cout << "atomic_snapshot torn or stale reads: " << snapshot_failures << '\n'
+		<< "triple_buffer torn or stale reads: " << triple_failures << '\n';
+	return snapshot_failures + triple_failures;
+}
@@ -0,0 +1,90 @@
+#include <ijk/attitude_filters.h>
+#include "expect.h"
+
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <vector>
+
+using namespace ijk::literals;
+
+static double angle_between(ijk::quat<float> const& a, ijk::quat<float> const& b)
+{
+	auto const d = a.w * b.w - (a.i * b.i + a.j * b.j + a.k * b.k);
+	return 2 * std::acos(std::min(std::abs(double{ d }), 1.));
+}
+
+int main()
+{
+	constexpr std::size_t count = 100; // not a multiple of the internal block size
+	constexpr float dt = 0.001f;
+	auto const still = ijk::vector<float>{};
+	auto const up = ijk::vector<float>{ 9.81_kf };
+	auto const quarter_turn = ijk::vector<float>{ ijk::K{ std::numbers::pi_v<float> / 2 } };
+
+	// At rest and level nothing moves
+	ijk::attitude_filters<float> level{ count };
+	std::vector<ijk::vector<float>> gyro(count, still), accel(count, up);
+	for (int tick = 0; tick < 1000; ++tick)
+	{
+		level.update(gyro, accel, dt);
+	}
+	expect_near(angle_between(level.orientation(count - 1), ijk::quat<float>{ 1.f }), 0., 1e-3, "level stays level");
+
+	// Without accelerometer correction a second of turning at a quarter turn per second is a quarter turn
+	ijk::attitude_filters<float> turning{ count, 0.f };
+	std::vector<ijk::vector<float>> turn(count, quarter_turn);
+	for (int tick = 0; tick < 1000; ++tick)
+	{
+		turning.update(turn, accel, dt);
+	}
+	auto const half = std::sqrt(0.5f);
+	expect_near(angle_between(turning.orientation(0), half + ijk::K{ half }), 0., 1e-3, "gyro integration");
+
+	// A filter started tilted is pulled back onto gravity, zero accel leaves it alone
+	ijk::attitude_filters<float> tilted{ count, 0.5f };
+	auto const tilt = ijk::quat<float>{ std::cos(0.25f), ijk::I{ std::sin(0.25f) } };
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		tilted.set_orientation(n, tilt);
+	}
+	accel[1] = still;
+	for (int tick = 0; tick < 5000; ++tick)
+	{
+		tilted.update(gyro, accel, dt);
+	}
+	auto const gravity = ijk::rotate(tilted.orientation(0).conjugate(), ijk::vector<float>{ 1_kf });
+	expect_near(gravity.z.value(), 1., 1e-3, "converges to gravity");
+	expect_near(angle_between(tilted.orientation(1), tilt), 0., 0., "zero accel skips correction");
+
+	// Filters are independent and both layouts agree
+	std::vector<ijk::vector<float>> mixed_gyro, mixed_accel;
+	std::vector<float> gx, gy, gz, ax, ay, az;
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		auto const f = static_cast<float>(n);
+		mixed_gyro.push_back(ijk::vector<float>{ ijk::I{ 0.01f * f }, ijk::J{ -0.02f }, ijk::K{ 0.5f } });
+		mixed_accel.push_back(ijk::vector<float>{ ijk::I{ 0.1f * f }, ijk::J{ 1.f }, ijk::K{ 9.f } });
+		gx.push_back(mixed_gyro[n].x.value());
+		gy.push_back(mixed_gyro[n].y.value());
+		gz.push_back(mixed_gyro[n].z.value());
+		ax.push_back(mixed_accel[n].x.value());
+		ay.push_back(mixed_accel[n].y.value());
+		az.push_back(mixed_accel[n].z.value());
+	}
+	ijk::attitude_filters<float> aos{ count }, soa{ count }, single{ 1 };
+	for (int tick = 0; tick < 100; ++tick)
+	{
+		aos.update(mixed_gyro, mixed_accel, dt);
+		soa.update(ijk::vector_soa_span<float const>{ gx, gy, gz }, ijk::vector_soa_span<float const>{ ax, ay, az }, dt);
+		single.update(std::span{ mixed_gyro }.subspan(77, 1), std::span{ mixed_accel }.subspan(77, 1), dt);
+	}
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		expect_near(angle_between(aos.orientation(n), soa.orientation(n)), 0., 1e-3, "AoS and SoA");
+	}
+	expect_near(angle_between(aos.orientation(77), single.orientation(0)), 0., 1e-3, "one of many equals one alone");
+
+	std::cout << "attitude filter failures: " << failures << '\n';
+	return failures;
+}
@@ -0,0 +1,81 @@
+#include <ijk/average.h>
+#include "expect.h"
+
+#include <cmath>
+#include <iostream>
+#include <numbers>
+#include <random>
+#include <vector>
+
+using namespace ijk::literals;
+
+static double angle_between(ijk::quat<double> const& a, ijk::quat<double> const& b)
+{
+	auto const d = a.w * b.w - (a.i * b.i + a.j * b.j + a.k * b.k);
+	return 2 * std::acos(std::min(std::abs(d), 1.));
+}
+
+static ijk::quat<double> axis_angle(ijk::vector<double> const& axis, double angle)
+{
+	auto const unit = axis / std::sqrt(ijk::dot(axis, axis));
+	auto const s = std::sin(angle / 2);
+	return ijk::quat<double>{ std::cos(angle / 2), unit.x * s, unit.y * s, unit.z * s };
+}
+
+int main()
+{
+	auto const truth = axis_angle(ijk::vector{ 1_i, 2_j, 3_k }, 1.);
+
+	// Small rotations about random axes with random signs, a naive sum would cancel out
+	std::mt19937 rng{ 42 };
+	std::normal_distribution<double> normal;
+	std::uniform_real_distribution<double> uniform{ 0., 1. };
+	std::vector<ijk::quat<double>> samples;
+	std::vector<double> weights;
+	for (int n = 0; n < 50001; ++n)
+	{
+		auto const axis = ijk::vector{ ijk::I{ normal(rng) }, ijk::J{ normal(rng) }, ijk::K{ normal(rng) } };
+		auto const q = axis_angle(axis, 0.1) * truth;
+		samples.push_back(n % 2 ? -q : q);
+		weights.push_back(0.5 + uniform(rng));
+	}
+
+	auto const serial = ijk::average(samples, { 1000, 1 });
+	expect_near(angle_between(serial.mean, truth), 0., 1e-3, "mean of noisy samples");
+	expect_near(serial.spread, 0.1, 1e-4, "spread is close to the common sample angle");
+	expect_near(serial.total_weight, 50001., 0., "unit weights");
+	expect_near(serial.mean.w, std::abs(serial.mean.w), 0., "w is non-negative");
+
+	// Same chunks, any thread count, identical sums
+	for (unsigned threads : { 2u, 3u, 8u })
+	{
+		auto const parallel = ijk::average(samples, { 1000, threads });
+		expect_near(angle_between(parallel.mean, serial.mean), 0., 0., "thread count does not change the result");
+	}
+
+	auto const weighted = ijk::average(samples, weights, { 4096, 4 });
+	expect_near(angle_between(weighted.mean, truth), 0., 1e-3, "weighted mean");
+
+	// Streaming in two halves and merging matches the batch
+	ijk::quat_accumulator<double> first, second;
+	for (std::size_t n = 0; n < samples.size(); ++n)
+	{
+		(n < samples.size() / 2 ? first : second).add(samples[n], weights[n]);
+	}
+	first.merge(second);
+	auto const streamed = first.result();
+	expect_near(angle_between(streamed.mean, weighted.mean), 0., 1e-6, "streamed mean"); // acos near 1 limits the precision of angle_between
+	expect_near(streamed.spread, weighted.spread, 1e-12, "streamed spread");
+
+	// Two samples a quarter turn apart average to the eighth turn between them
+	ijk::quat_accumulator<double> pair;
+	auto const quarter = axis_angle(ijk::vector{ 1_k }, std::numbers::pi / 2);
+	pair.add(ijk::quat<double>{ 1. });
+	pair.add(-quarter);
+	auto const between = pair.result();
+	expect_near(angle_between(between.mean, axis_angle(ijk::vector{ 1_k }, std::numbers::pi / 4)), 0., 1e-6, "midpoint");
+	expect_near(between.spread, std::numbers::pi / 4, 1e-12, "midpoint spread");
+
+	std::cout << "mean " << serial.mean << " spread " << serial.spread << ", failures: " << failures << '\n';
+	return failures;
+}
@@ -0,0 +1,146 @@
+#include <ijk/batch.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ijk::literals;
+
+static bool near(ijk::vector<double> const& a, ijk::vector<double> const& b)
+{
+	auto const d = a - b;
+	return std::sqrt(ijk::dot(d, d)) < 1e-12;
+}
+
+int main()
+{
+	std::mt19937 rng{ 1234 };
+	std::uniform_real_distribution<double> coordinate{ -10., 10. };
+
+	constexpr std::size_t count = 20011; // not a multiple of any chunk size
+	std::vector<ijk::vector<double>> points(count);
+	std::vector<double> xs(count), ys(count), zs(count);
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		points[n] = ijk::vector<double>{ ijk::I{ coordinate(rng) }, ijk::J{ coordinate(rng) }, ijk::K{ coordinate(rng) } };
+		xs[n] = points[n].x.value();
+		ys[n] = points[n].y.value();
+		zs[n] = points[n].z.value();
+	}
+
+	// 90 degrees about k then half of the way around the diagonal
+	auto const half = std::sqrt(0.5);
+	auto const q = (half + ijk::K{ half }) * (0.5 + 0.5_i + 0.5_j + 0.5_k);
+	auto const translation = ijk::vector{ 1_i, -2_j, 3_k };
+
+	std::vector<ijk::vector<double>> expected(count);
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		expected[n] = ijk::rotate(q, points[n]) + translation;
+	}
+
+	int failures = 0;
+	auto check = [&](auto const& result, char const* what, std::vector<ijk::vector<double>> const& expected)
+		{
+			for (std::size_t n = 0; n < count; ++n)
+			{
+				if (!near(result(n), expected[n]))
+				{
+					std::cout << what << " differs at " << n << ": " << result(n) << " != " << expected[n] << '\n';
+					++failures;
+					return;
+				}
+			}
+		};
+
+	for (unsigned threads : { 1u, 2u, 3u, 8u })
+	{
+		for (std::size_t chunk : { std::size_t{ 1000 }, std::size_t{ 1 << 14 } })
+		{
+			ijk::batch_options const options{ chunk, threads };
+
+			std::vector<ijk::vector<double>> out(count);
+			ijk::transform(q, translation, points, out, options);
+			check([&](std::size_t n) { return out[n]; }, "AoS", expected);
+
+			auto in_place = points;
+			ijk::rotate(q, in_place, options);
+			ijk::transform(ijk::quat<double>{ 1. }, translation, in_place, options);
+			check([&](std::size_t n) { return in_place[n]; }, "AoS in place", expected);
+
+			auto x = xs, y = ys, z = zs;
+			ijk::transform(q, translation, ijk::vector_soa_span<double>{ x, y, z }, options);
+			check([&](std::size_t n) { return ijk::vector{ ijk::I{ x[n] }, ijk::J{ y[n] }, ijk::K{ z[n] } }; }, "SoA in place", expected);
+		}
+	}
+
+	// Blocks of 10 points alternate between q and its inverse
+	std::vector<ijk::quat<double>> rotations((count + 9) / 10);
+	for (std::size_t s = 0; s < rotations.size(); ++s)
+	{
+		rotations[s] = s % 2 ? q.conjugate() : q;
+	}
+	std::vector<ijk::vector<double>> segmented(count), expected_segmented(count);
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		expected_segmented[n] = ijk::rotate(rotations[n / 10], points[n]);
+	}
+	ijk::rotate_segments(rotations, 10, points, segmented, { 64, 4 });
+	check([&](std::size_t n) { return segmented[n]; }, "segments", expected_segmented);
+
+	auto segmented_in_place = points;
+	ijk::rotate_segments(rotations, 10, segmented_in_place, { 64, 4 });
+	check([&](std::size_t n) { return segmented_in_place[n]; }, "segments in place", expected_segmented);
+
+	std::vector<double> sx(count), sy(count), sz(count);
+	ijk::rotate_segments(rotations, 10, ijk::vector_soa_span<double const>{ xs, ys, zs }, ijk::vector_soa_span<double>{ sx, sy, sz }, { 64, 4 });
+	check([&](std::size_t n) { return ijk::vector{ ijk::I{ sx[n] }, ijk::J{ sy[n] }, ijk::K{ sz[n] } }; }, "SoA segments", expected_segmented);
+
+	auto x = xs, y = ys, z = zs;
+	ijk::rotate_segments(rotations, 10, ijk::vector_soa_span<double>{ x, y, z }, { 64, 4 });
+	check([&](std::size_t n) { return ijk::vector{ ijk::I{ x[n] }, ijk::J{ y[n] }, ijk::K{ z[n] } }; }, "SoA segments in place", expected_segmented);
+
+	// Caller owned pool, and a batch call made from inside a job runs on the thread making it
+	ijk::thread_pool pool{ 3 };
+	std::vector<ijk::vector<double>> pooled(count);
+	ijk::transform(q, translation, points, pooled, { 1000, 4, &pool });
+	check([&](std::size_t n) { return pooled[n]; }, "caller owned pool", expected);
+
+	std::vector<std::vector<ijk::vector<double>>> nested(4, points);
+	ijk::detail::parallel_chunks(nested.size(), { 1, 4, &pool }, [&](std::size_t begin, std::size_t end)
+		{
+			for (auto n = begin; n < end; ++n)
+			{
+				ijk::transform(q, translation, nested[n], { 1000, 4, &pool });
+			}
+		});
+	for (auto const& result : nested)
+	{
+		check([&](std::size_t n) { return result[n]; }, "nested", expected);
+	}
+
+	// A job on pool that calls into other_pool, whose job calls back into pool, also runs inline
+	ijk::thread_pool other_pool{ 2 };
+	std::vector<std::vector<ijk::vector<double>>> chained(4, points);
+	ijk::detail::parallel_chunks(2, { 1, 2, &pool }, [&](std::size_t begin, std::size_t end)
+		{
+			for (auto outer = begin; outer < end; ++outer)
+			{
+				ijk::detail::parallel_chunks(2, { 1, 2, &other_pool }, [&](std::size_t inner_begin, std::size_t inner_end)
+					{
+						for (auto inner = inner_begin; inner < inner_end; ++inner)
+						{
+							ijk::transform(q, translation, chained[outer * 2 + inner], { 1000, 4, &pool });
+						}
+					});
+			}
+		});
+	for (auto const& result : chained)
+	{
+		check([&](std::size_t n) { return result[n]; }, "chained pools", expected);
+	}
+
+	std::cout << "rotated " << count << " points, failures: " << failures << '\n';
+	return failures;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cmath>
+#include <iostream>
+
+// Run time checks for what static_assert cannot cover, a test's main returns the failure count
+
+inline int failures = 0;
+
+inline void expect(bool ok, char const* what)
+{
+	if (!ok)
+	{
+		std::cout << "failed: " << what << '\n';
+		++failures;
+	}
+}
+
+template<typename A, typename B>
+void expect_equal(A const& actual, B const& expected, char const* what)
+{
+	if (!(actual == expected))
+	{
+		std::cout << what << ": " << actual << " != " << expected << '\n';
+		++failures;
+	}
+}
+
+inline void expect_near(double actual, double expected, double tolerance, char const* what)
+{
+	if (!(std::abs(actual - expected) <= tolerance))
+	{
+		std::cout << what << ": " << actual << " != " << expected << '\n';
+		++failures;
+	}
+}
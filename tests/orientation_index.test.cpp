@@ -0,0 +1,124 @@
+#include <ijk/orientation_index.h>
+#include "expect.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using namespace ijk::literals;
+
+static std::vector<ijk::quat<float>> random_orientations(std::size_t count, unsigned seed)
+{
+	std::mt19937 rng{ seed };
+	std::normal_distribution<float> normal;
+	std::vector<ijk::quat<float>> result;
+	for (std::size_t n = 0; n < count; ++n)
+	{
+		float c[4];
+		float length = 0;
+		for (auto& x : c)
+		{
+			x = normal(rng);
+			length += x * x;
+		}
+		length = std::sqrt(length);
+		result.push_back(ijk::quat<float>{ c[0] / length, ijk::I{ c[1] / length }, ijk::J{ c[2] / length }, ijk::K{ c[3] / length } });
+	}
+	return result;
+}
+
+// Same distance as the index, sorted the same way
+static std::vector<ijk::neighbour<float>> brute_force(std::vector<ijk::quat<float>> const& library, ijk::quat<float> const& query)
+{
+	std::vector<std::pair<float, std::size_t>> all;
+	for (std::size_t n = 0; n < library.size(); ++n)
+	{
+		all.emplace_back(ijk::detail::orientation_chord(ijk::detail::components(query), ijk::detail::components(library[n])), n);
+	}
+	std::sort(all.begin(), all.end());
+	std::vector<ijk::neighbour<float>> result;
+	for (auto const& [chord, n] : all)
+	{
+		result.push_back({ n, ijk::detail::chord_to_angle(chord) });
+	}
+	return result;
+}
+
+int main()
+{
+	auto const library = random_orientations(20000, 1);
+	auto const queries = random_orientations(50, 2);
+	ijk::orientation_index<float> const index{ library, { 1 << 14, 4 } };
+	expect(index.size() == library.size(), "size");
+
+	for (auto const& query : queries)
+	{
+		auto const expected = brute_force(library, query);
+		for (std::size_t k : { 1, 5, 32 })
+		{
+			auto const found = index.nearest(query, k);
+			expect(std::equal(found.begin(), found.end(), expected.begin(), expected.begin() + k), "nearest matches brute force");
+		}
+
+		auto const reach = 0.4f;
+		auto const close = index.within(query, reach);
+		auto const expected_close = std::ranges::count_if(expected, [&](auto const& m) { return m.angle <= reach; });
+		expect(std::equal(close.begin(), close.end(), expected.begin(), expected.begin() + expected_close), "within matches brute force");
+	}
+
+	// q and -q are the same orientation
+	auto const flipped = index.nearest(-library[123], 1);
+	expect(flipped.size() == 1 && flipped[0].index == 123 && flipped[0].angle == 0.f, "antipodal query");
+
+	// The tree does not depend on the number of threads building it
+	ijk::orientation_index<float> const single{ library, { 1 << 14, 1 } };
+	expect(single.serialize() == index.serialize(), "build is deterministic");
+
+	auto const bytes = index.serialize();
+	auto const loaded = ijk::orientation_index<float>::deserialize(bytes);
+	expect(loaded.has_value() && loaded->nearest(queries[0], 8) == index.nearest(queries[0], 8), "serialize round trip");
+	expect(!ijk::orientation_index<double>::deserialize(bytes), "value type is checked");
+	expect(!ijk::orientation_index<float>::deserialize(std::span{ bytes }.first(bytes.size() - 1)), "length is checked");
+
+	// Header count chosen so that the expected size wraps around to the size of the buffer
+	std::vector<std::byte> crafted(bytes.begin(), bytes.begin() + 48);
+	std::uint64_t const wrapping_count = (std::uint64_t{ 1 } << 61) + 1;
+	std::memcpy(crafted.data() + 16, &wrapping_count, sizeof(wrapping_count));
+	expect(!ijk::orientation_index<float>::deserialize(crafted), "count is checked before it is multiplied");
+
+	auto bad_id = bytes;
+	std::uint32_t const out_of_range = static_cast<std::uint32_t>(library.size());
+	std::memcpy(bad_id.data() + 24 + library.size() * 16, &out_of_range, sizeof(out_of_range));
+	expect(!ijk::orientation_index<float>::deserialize(bad_id), "ids are checked");
+
+	// Many equal distances, the build has to stay fast and correct
+	std::vector<ijk::quat<float>> repeated;
+	for (std::size_t n = 0; n < 30000; ++n)
+	{
+		repeated.push_back(library[n % 3]);
+	}
+	ijk::orientation_index<float> const duplicates{ repeated, { 1 << 14, 4 } };
+	auto const same = duplicates.nearest(library[1], 5);
+	expect(same.size() == 5 && same.back().angle == 0 && same.front().index % 3 == 1, "duplicate orientations");
+
+	std::vector<ijk::neighbour<float>> batch(queries.size() * 3);
+	index.nearest(queries, 3, batch, { 1024, 3 });
+	auto const batch_within = index.within(queries, 0.3f, { 1024, 3 });
+	for (std::size_t n = 0; n < queries.size(); ++n)
+	{
+		expect(std::equal(batch.begin() + n * 3, batch.begin() + n * 3 + 3, index.nearest(queries[n], 3).begin()), "batched nearest");
+		expect(batch_within[n] == index.within(queries[n], 0.3f), "batched within");
+	}
+
+	ijk::orientation_index<float> const tiny{ std::span{ library }.first(2) };
+	std::vector<ijk::neighbour<float>> padded(4);
+	tiny.nearest(std::span{ queries }.first(1), 4, padded);
+	expect(padded[2].index == 2 && std::isinf(padded[3].angle), "missing matches are padded");
+	expect(tiny.nearest(queries[0], std::size_t{ 1 } << 40).size() == 2, "k larger than the index");
+
+	std::cout << "orientation index failures: " << failures << '\n';
+	return failures;
+}
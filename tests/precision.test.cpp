@@ -0,0 +1,111 @@
+#include <ijk/precision.h>
+#include <ijk/average.h>
+#include "expect.h"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <list>
+#include <ranges>
+#include <sstream>
+#include <vector>
+
+using namespace ijk::literals;
+using ijk::precision;
+namespace accumulation = ijk::accumulation;
+
+using narrow = precision<float>;
+using mixed = precision<float, double>;
+using compensated = precision<float, float, accumulation::kahan>;
+using pairwise = precision<float, double, accumulation::pairwise>;
+
+// Storage type decides the result, not std::common_type
+static_assert(std::same_as<decltype(1_jf + 1_jl), ijk::J<long double>>);
+static_assert(std::same_as<decltype(ijk::add<mixed>(1_jf, 1_jl)), ijk::J<float>>);
+static_assert(std::same_as<decltype(ijk::multiply<mixed>(1.f + 1_if, 2.L + 0_il)), ijk::complex<float>>);
+static_assert(std::same_as<decltype(ijk::subtract<precision<double>>(ijk::vector{ 1_if }, ijk::vector{ 1_jf })), ijk::vector<double>>);
+
+static_assert(ijk::add<mixed>(1_jf, 1_jl) == 2_jf);
+static_assert(ijk::multiply<mixed>(1_i, 1_j) == 1_kf);
+static_assert(ijk::multiply<mixed>(1. + 2_i + 3_j + 4_k, 5. + 6_i + 7_j + 8_k) == ijk::quat<float>{ -60.f, 12_if, 30_jf, 24_kf });
+
+static constexpr std::array quats{ 1. + 2_i + 3_j + 4_k, 5. + 6_i + 7_j + 8_k, 9. + 0_i + 0_j + 0_k };
+static_assert(ijk::sum<compensated>(quats) == ijk::quat<float>{ 15.f, 8_if, 10_jf, 12_kf });
+static_assert(ijk::sum<pairwise>(quats) == ijk::sum<narrow>(quats));
+static_assert(ijk::product<narrow>(quats) == ijk::quat<float>{ quats[0] * quats[1] * quats[2] });
+static_assert(ijk::product<pairwise>(quats) == ijk::product<narrow>(quats));
+static_assert(ijk::product<narrow>(std::array<ijk::quat<double>, 0>{}) == ijk::quat<float>{ 1.f }, "empty product is the identity");
+static_assert(ijk::sum<narrow>(std::array{ 0.5, 0.25 }) == 0.75f);
+
+// Compensated products exist for scalars only
+template<typename Policy, typename R>
+concept has_product = requires(R const& values) { ijk::product<Policy>(values); };
+static_assert(has_product<compensated, std::array<float, 2>>);
+static_assert(!has_product<compensated, decltype(quats)>);
+static_assert(!has_product<pairwise, std::list<float>>);
+
+int main()
+{
+	// A million tenths stored as float
+	std::vector<ijk::vector<float>> steps(1000000, ijk::vector<float>{ 0.1_if, -0.1_jf, 0.001_kf });
+	auto const exact_x = 1000000 * double{ 0.1f };
+	auto const error = [&](ijk::vector<float> const& v) { return std::abs(v.x.value() - exact_x); };
+
+	auto const plain = ijk::sum<narrow>(steps);
+	auto const kahan = ijk::sum<compensated>(steps);
+	auto const wide = ijk::sum<mixed>(steps);
+	auto const tree = ijk::sum<precision<float, float, accumulation::pairwise>>(steps);
+	std::cout << "float sum errors: plain " << error(plain) << ", kahan " << error(kahan)
+		<< ", pairwise " << error(tree) << ", double " << error(wide) << '\n';
+	expect(error(plain) > 100, "plain float sum drifts");
+	expect(error(kahan) < 0.01, "kahan float sum keeps up");
+	expect(error(tree) < 0.1, "pairwise float sum keeps up");
+	expect(error(wide) < 0.01, "double sum keeps up");
+
+	// Input ranges without random access work with everything but pairwise
+	std::list<float> listed(1000, 0.1f);
+	expect(std::abs(ijk::sum<compensated>(listed) - 1000 * double{ 0.1f }) < 1e-3, "list sum");
+	expect(std::abs(ijk::sum<compensated>(listed | std::views::filter([](float x) { return x > 0; })) - 1000 * double{ 0.1f }) < 1e-3, "filtered sum");
+	std::istringstream text{ "0.5 0.25 0.125" };
+	expect(ijk::sum<compensated>(std::views::istream<float>(text)) == 0.875f, "single pass sum");
+
+	// Scalar products: compensated float gets as close as float can to the exact product
+	std::vector<float> factors(10000);
+	long double exact_product = 1;
+	for (std::size_t n = 0; n < factors.size(); ++n)
+	{
+		factors[n] = 1.f + static_cast<float>(n % 7) * 1e-5f;
+		exact_product *= factors[n];
+	}
+	auto const scalar_error = [&](float p) { return std::abs(static_cast<long double>(p) - exact_product) / exact_product; };
+	auto const plain_product = ijk::product<narrow>(factors);
+	auto const kahan_product = ijk::product<compensated>(factors);
+	std::cout << "scalar product relative errors: plain " << static_cast<double>(scalar_error(plain_product))
+		<< ", kahan " << static_cast<double>(scalar_error(kahan_product)) << '\n';
+	expect(scalar_error(kahan_product) < 1e-7 && scalar_error(kahan_product) < scalar_error(plain_product), "compensated product");
+
+	// A long chain of small rotations
+	auto const angle = 1e-3;
+	auto const step = ijk::quat<float>{ static_cast<float>(std::cos(angle / 2)), ijk::K{ static_cast<float>(std::sin(angle / 2)) } };
+	std::vector<ijk::quat<float>> chain(100000, step);
+	// The float step is not quite unit length, its norm to the power of the chain length is exact enough in double
+	auto const step_norm_squared = double{ step.w } * step.w + double{ step.k.value() } * step.k.value();
+	auto const exact_norm = std::pow(step_norm_squared, chain.size() / 2.);
+	auto const norm = [](ijk::quat<float> const& q) { return std::sqrt(double{ q.w } * q.w + double{ q.k.value() } * q.k.value()); };
+	auto const narrow_product = ijk::product<narrow>(chain);
+	auto const wide_product = ijk::product<pairwise>(chain);
+	std::cout << "product norm errors: float " << std::abs(norm(narrow_product) - exact_norm)
+		<< ", double pairwise " << std::abs(norm(wide_product) - exact_norm) << '\n';
+	expect(std::abs(norm(wide_product) - exact_norm) < 1e-6, "wide product");
+	expect(std::abs(norm(wide_product) - exact_norm) < std::abs(norm(narrow_product) - exact_norm), "wide product beats float");
+
+	// Averaging float samples in double
+	std::vector<ijk::quat<float>> samples(200000, ijk::quat<float>{ 0.6f, 0.8_if });
+	auto const mean = ijk::average<precision<float, double, accumulation::kahan>>(samples, { 1 << 20, 2 });
+	static_assert(std::same_as<decltype(mean), ijk::quat_average<float> const>);
+	expect(std::abs(mean.mean.w - 0.6f) < 1e-6f && std::abs(mean.mean.i.value() - 0.8f) < 1e-6f, "average in double");
+	expect(mean.total_weight == 200000.f, "average weight");
+
+	std::cout << "precision failures: " << failures << '\n';
+	return failures;
+}
@@ -30,6 +30,17 @@ static_assert(1_j * qi == -qk, "ji = -k without quaternion left argument");
 static_assert(1_i * 1_j == 1_k, "ij = k but still only using directed values not quaternions");
 static_assert(std::same_as<decltype(1_i * 1_j), ijk::K<double>>, "directed value multiplication gives another directed value instead of quaternion");
 static_assert(std::same_as<decltype(1_i * 2_i), double>, "but multiplication of same direction gives scalar");
+static_assert(std::same_as<decltype(2. * ijk::vector{ 1_i }), ijk::vector<double>>, "scalar times vector is not a quaternion");
+static_assert(std::same_as<decltype((1. + 1_i) * (1. + 1_i)), ijk::complex<double>>, "complex times complex is not a quaternion");
+
+// half turns about each axis
+constexpr auto p = ijk::vector{ 1_i, 2_j, 3_k };
+static_assert(rotate(qk, p) == ijk::vector{ -1_i, -2_j, 3_k });
+static_assert(rotate(qi, p) == ijk::vector{ 1_i, -2_j, -3_k });
+static_assert(rotate(quat<double>{ 1. }, p) == p, "identity rotation");
+// quarter turn about the diagonal cycles the axes
+static_assert(rotate(0.5 + 0.5_i + 0.5_j + 0.5_k, p) == ijk::vector{ 3_i, 1_j, 2_k });
+static_assert(rotate(qk * qi, p) == rotate(qk, rotate(qi, p)), "rotating by a product rotates by the right factor first");
 
 int main(){
 	ijk::quat<double> q{ 123.456, K{ 789.f }, J{ 21.37 } };
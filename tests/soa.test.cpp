@@ -0,0 +1,144 @@
+#include <ijk/soa.h>
+#include "expect.h"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory_resource>
+#include <new>
+
+using namespace ijk::literals;
+
+// Every heap allocation in this program goes through here
+static std::atomic<long> heap_allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+	++heap_allocations;
+	if (void* p = std::malloc(size ? size : 1))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment)
+{
+	++heap_allocations;
+	auto const align = static_cast<std::size_t>(alignment);
+	if (void* p = std::aligned_alloc(align, (size + align - 1) / align * align))
+	{
+		return p;
+	}
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+void operator delete(void* p, std::align_val_t) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { std::free(p); }
+
+template<typename Container>
+static bool aligned(Container const& c)
+{
+	for (std::size_t n = 0; n < Container::component_count; ++n)
+	{
+		if (reinterpret_cast<std::uintptr_t>(c.component(n).data()) % 64 != 0)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+static_assert(ijk::soa_vector<ijk::quat<float>>::component_count == 4);
+static_assert(ijk::soa_vector<ijk::complex<double>>::component_count == 2);
+static_assert(ijk::soa_vector<ijk::vector<float>>::component_count == 3);
+
+// One frame of temporaries, the same work every frame
+static float frame(ijk::quat<float> const& q, int frame_number)
+{
+	float checksum = 0;
+	{
+		ijk::frame_soa_vector<ijk::vector<float>> points;
+		ijk::frame_soa_vector<ijk::quat<float>> orientations;
+		ijk::frame_soa_vector<ijk::complex<float>> phases;
+		for (int n = 0; n < 30000; ++n)
+		{
+			auto const f = static_cast<float>(n + frame_number);
+			points.push_back(ijk::vector<float>{ ijk::I{ f }, ijk::J{ 1.f }, ijk::K{ -f } });
+			orientations.push_back(q);
+			phases.push_back(ijk::complex<float>{ f, ijk::I{ 1.f } });
+		}
+		// Default options, more than one chunk, runs on the shared thread pool
+		ijk::rotate(q, points.soa());
+		checksum = points[10].x.value() + orientations[5].w + phases[7].real;
+	}
+	// The frame's containers are gone, their memory can be handed out again
+	ijk::thread_frame_arena().reset();
+	return checksum;
+}
+
+int main()
+{
+	ijk::soa_vector<ijk::quat<double>> quats;
+	quats.push_back(1. + 2_i + 3_j + 4_k);
+	quats.push_back(5. + 6_i + 7_j + 8_k);
+	expect(quats.size() == 2 && quats[0] == 1. + 2_i + 3_j + 4_k && quats[1] == 5. + 6_i + 7_j + 8_k, "push_back and index");
+	expect(quats.component(2)[1] == 7., "component order follows the members");
+	expect(aligned(quats), "components are cache line aligned");
+
+	for (int n = 0; n < 1000; ++n)
+	{
+		quats.push_back(ijk::quat<double>{ static_cast<double>(n) });
+	}
+	expect(quats.size() == 1002 && quats[1] == 5. + 6_i + 7_j + 8_k && quats[1001].w == 999., "growth keeps values");
+	expect(aligned(quats), "still aligned after growth");
+
+	auto copy = quats;
+	quats.resize(5);
+	expect(copy.size() == 1002 && copy[1001].w == 999., "copy is independent");
+	quats.resize(8);
+	expect(quats[7] == ijk::quat<double>{} && quats[4].w == 2., "resize zero fills");
+
+	auto moved = std::move(copy);
+	expect(moved.size() == 1002 && copy.empty(), "move");
+
+	// Vectors plug into the batch transforms
+	ijk::soa_vector<ijk::vector<double>> points{ 4 };
+	points.set(1, ijk::vector{ 1_i, 2_j, 3_k });
+	ijk::rotate(ijk::quat<double>{ 1_k }, points.soa());
+	expect(points[1] == ijk::vector{ -1_i, -2_j, 3_k } && points[0] == ijk::vector<double>{}, "soa span");
+
+	// polymorphic allocator with a bundled arena, the arena's upstream is the default heap
+	{
+		ijk::monotonic_arena arena;
+		ijk::pmr::soa_vector<ijk::complex<float>> phases{ &arena };
+		phases.push_back(1.f + 2_if);
+		expect(phases.get_allocator().resource() == &arena && phases[0] == 1.f + 2_if, "pmr");
+		expect(aligned(phases), "pmr alignment");
+	}
+
+	// Allocation count per frame: the first frames grow the thread's arena, after that nothing
+	auto const q = 0.5f + ijk::I{ 0.5f } + ijk::J{ 0.5f } + ijk::K{ 0.5f };
+	float checksum = 0;
+	long per_frame[8];
+	for (auto& allocations : per_frame)
+	{
+		auto const before = heap_allocations.load();
+		checksum += frame(q, 0);
+		allocations = heap_allocations.load() - before;
+	}
+	std::cout << "heap allocations per frame:";
+	for (auto allocations : per_frame)
+	{
+		std::cout << ' ' << allocations;
+	}
+	std::cout << '\n';
+	expect(per_frame[0] > 0, "warm up frame allocates");
+	expect(per_frame[7] == 0 && per_frame[6] == 0, "steady state frames do not allocate");
+
+	std::cout << "checksum " << checksum << ", soa failures: " << failures << '\n';
+	return failures;
+}
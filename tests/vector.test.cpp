@@ -50,6 +50,14 @@ static_assert(vec_f.x.value() == vec_d.x.value());
 static_assert(vec_f.y.value() == vec_d.y.value());
 static_assert(vec_f.z.value() == vec_d.z.value());
 
+// dot and cross products fall out of the direction identities
+static_assert(ijk::dot(a, b) == 22.f);
+static_assert(ijk::dot(a, a) == 14.f);
+static_assert(ijk::cross(ijk::vector{ 1_i }, ijk::vector{ 1_j }) == ijk::vector{ 1_k });
+static_assert(ijk::cross(a, b) == ijk::vector<float>{ -6_i, 12_j, -6_k });
+static_assert(ijk::cross(a, b) == -1.f * ijk::cross(b, a));
+static_assert(ijk::dot(a, ijk::cross(a, b)) == 0.f);
+
 
 #include <iostream>
 
@@ -0,0 +1,77 @@
+#include <ijk/views.h>
+#include "expect.h"
+
+#include <array>
+#include <cmath>
+#include <iostream>
+#include <limits>
+#include <vector>
+
+using namespace ijk::literals;
+namespace views = ijk::views;
+
+static constexpr auto qk = ijk::quat<double>{ 1_k };        // half turn about k
+static constexpr auto qd = 0.5 + 0.5_i + 0.5_j + 0.5_k;     // quarter turn about the diagonal
+static constexpr auto shift = ijk::vector{ 1_i, 2_j, 3_k };
+
+static std::vector<ijk::vector<double>> points{ ijk::vector{ 1_i }, ijk::vector{ 2_j, 3_k }, shift };
+static std::vector<ijk::quat<double>> orientations{ qk, qd, 1. + 2_i + 3_j + 4_k };
+
+// Chained transforms stay one view with one fused transform
+using rotated_t = decltype(points | views::rotate(qk));
+static_assert(std::same_as<decltype(points | views::rotate(qk) | views::rotate(qd) | views::translate(shift)), rotated_t>);
+using multiplied_t = decltype(orientations | views::multiply(qk));
+static_assert(std::same_as<decltype(orientations | views::multiply(qk) | views::conjugate | views::multiply(qd)), multiplied_t>);
+static_assert(std::same_as<decltype(orientations | views::conjugate), multiplied_t>);
+static_assert(std::ranges::random_access_range<rotated_t> && std::ranges::sized_range<rotated_t>);
+
+// Fusing the transforms themselves
+static_assert((views::rotate(qk) | views::rotate(qd))(shift) == ijk::rotate(qd, ijk::rotate(qk, shift)));
+static_assert((views::translate(shift) | views::rotate(qk))(shift) == ijk::rotate(qk, shift + shift));
+
+int main()
+{
+	auto const rigid = points | views::rotate(qk) | views::translate(shift) | views::rotate(qd);
+	expect_equal(rigid.size(), points.size(), "size");
+	for (std::size_t n = 0; n < points.size(); ++n)
+	{
+		expect_equal(rigid[n], ijk::rotate(qd, ijk::rotate(qk, points[n]) + shift), "rotate translate rotate");
+	}
+
+	auto const chained = orientations | views::multiply(qk) | views::conjugate | views::multiply(qd) | views::conjugate;
+	for (std::size_t n = 0; n < orientations.size(); ++n)
+	{
+		auto const expected = ((orientations[n] * qk).conjugate() * qd).conjugate();
+		expect_equal(chained[n], expected, "multiply conjugate multiply conjugate");
+	}
+
+	auto n = std::size_t{ 0 };
+	for (auto const& q : orientations | views::conjugate | views::multiply(qk))
+	{
+		expect_equal(q, orientations[n++].conjugate() * qk, "conjugate multiply");
+	}
+
+	// Views over views from the standard library are fine too
+	for (auto const& v : points | std::views::reverse | views::translate(shift) | std::views::take(1))
+	{
+		expect_equal(v, points.back() + shift, "reverse translate take");
+	}
+
+	// Identity parts are skipped, so values the full products would turn into NaN or +0 pass through
+	auto const inf = std::numeric_limits<double>::infinity();
+	std::vector<ijk::quat<double>> non_finite{ ijk::quat<double>{ 1., ijk::I{ inf } }, ijk::quat<double>{ 2. } };
+	auto const conjugated = non_finite | views::conjugate;
+	expect_equal(conjugated[0], ijk::quat<double>{ 1., ijk::I{ -inf } }, "conjugate infinity");
+	expect(std::signbit(conjugated[1].i.value()) && std::signbit(conjugated[1].k.value()), "conjugate signed zero");
+	expect_equal((non_finite | views::conjugate | views::conjugate)[0], non_finite[0], "conjugate twice");
+	expect_equal((non_finite | views::multiply(qk))[1], non_finite[1] * qk, "single multiply");
+
+	std::vector<ijk::vector<double>> far{ ijk::vector{ ijk::I{ inf }, 2_j, -ijk::K{ 0. } } };
+	auto const translated = (far | views::translate(shift))[0];
+	expect(translated.x.value() == inf && translated.y.value() == 4 && translated.z.value() == 3, "translate infinity");
+	auto const untouched = (far | views::translate(shift) | views::translate(ijk::vector{ -1_i, -2_j, -3_k }))[0];
+	expect(untouched.x.value() == inf && untouched.y.value() == 2 && untouched.z.value() == 0, "translate there and back");
+
+	std::cout << "view failures: " << failures << '\n';
+	return failures;
+}